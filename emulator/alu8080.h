@@ -0,0 +1,314 @@
+#pragma once
+
+#include <cstdint>
+#include "emulator_shell.h"
+
+// Flag bits as they sit in the packed 8080 PSW byte
+//   |7 |6 |5 |4 |3 |2 |1 |0 |
+//   |s |z |- |ac|- |p |1 |cy|
+const uint8_t FlagS = 0x80;
+const uint8_t FlagZ = 0x40;
+const uint8_t FlagAC = 0x10;
+const uint8_t FlagP = 0x04;
+const uint8_t FlagOne = 0x02; // bit 1 always reads back as 1
+const uint8_t FlagCY = 0x01;
+
+// A and the flag bits that exist, for pushing and popping State8080::psw as one word
+const uint16_t PswMask = 0xFF00 | FlagS | FlagZ | FlagAC | FlagP | FlagCY;
+
+// Precomputed flag bytes so every flag update is a single load
+// zsp holds S, Z and P (plus the always-one bit) for an 8 bit result.
+// carry is indexed by the 9 bit result of an add or a subtract: the low byte gives S, Z and P
+// and bit 8 is the carry out of an add or the borrow out of a subtract, so one table serves both
+typedef struct FlagTables {
+    uint8_t zsp[256];
+    uint8_t carry[512];
+} FlagTables;
+
+constexpr FlagTables BuildFlagTables()
+{
+    FlagTables tables{};
+    for (int i = 0; i < 512; i++)
+    {
+        uint8_t value = uint8_t(i);
+        int setBits = 0;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            setBits += (value >> bit) & 1;
+        }
+        uint8_t zsp = uint8_t((value & FlagS) | (value == 0 ? FlagZ : 0) | ((setBits & 1) ? 0 : FlagP) | FlagOne);
+        if (i < 256)
+        {
+            tables.zsp[i] = zsp;
+        }
+        tables.carry[i] = uint8_t(zsp | (i > 0xFF ? FlagCY : 0));
+    }
+    return tables;
+}
+
+inline constexpr FlagTables Flags8080 = BuildFlagTables();
+
+// Lazy flag mode records the last flag-setting ALU operation in State8080 instead of
+// building the flag byte, then ResolveLazyFlags builds it only when an instruction reads it
+enum LazyFlagOp : uint8_t {
+    LazyNone = 0, // state->flags is up to date
+    LazyAdd,
+    LazySubtract,
+    LazyAnd,
+    LazyLogic, // XRA and ORA
+    LazyIncrement,
+    LazyDecrement,
+};
+
+inline void RecordLazyFlags(CPU::State8080 *state, LazyFlagOp op, uint8_t lhs, uint8_t rhs, uint16_t result)
+{
+    state->lazy_op = op;
+    state->lazy_lhs = lhs;
+    state->lazy_rhs = rhs;
+    state->lazy_result = result;
+}
+
+// Builds the flag byte from the recorded operation, the same values the eager helpers produce
+inline void ResolveLazyFlags(CPU::State8080 *state)
+{
+    uint8_t lhs = state->lazy_lhs;
+    uint8_t rhs = state->lazy_rhs;
+    uint16_t result = state->lazy_result;
+    switch (state->lazy_op)
+    {
+    case LazyNone:
+        return;
+    case LazyAdd:
+        state->flags = Flags8080.carry[result] | ((lhs ^ rhs ^ result) & FlagAC);
+        break;
+    case LazySubtract:
+        state->flags = Flags8080.carry[result] | (~(lhs ^ rhs ^ result) & FlagAC);
+        break;
+    case LazyAnd:
+        state->flags = Flags8080.zsp[result] | (((lhs | rhs) & 0x08) << 1);
+        break;
+    case LazyLogic:
+        state->flags = Flags8080.zsp[result];
+        break;
+    case LazyIncrement: // rhs holds the carry that was current before the INR
+        state->flags = rhs | Flags8080.zsp[result] | ((result & 0x0F) == 0x00 ? FlagAC : 0);
+        break;
+    case LazyDecrement:
+        state->flags = rhs | Flags8080.zsp[result] | ((result & 0x0F) == 0x0F ? 0 : FlagAC);
+        break;
+    }
+    state->lazy_op = LazyNone;
+}
+
+// CY alone without resolving the rest, INR and DCR need it to carry it through
+inline uint8_t LazyCarry(CPU::State8080 *state)
+{
+    switch (state->lazy_op)
+    {
+    case LazyAdd:
+    case LazySubtract:
+        return state->lazy_result >> 8;
+    case LazyAnd:
+    case LazyLogic:
+        return 0;
+    case LazyIncrement:
+    case LazyDecrement:
+        return state->lazy_rhs;
+    default:
+        return state->flags & FlagCY;
+    }
+}
+
+// The helpers below take LazyFlags as a template parameter so each interpreter core is
+// compiled once per flag mode without a runtime check inside every ALU instruction.
+// In eager mode they only touch a and flags, so state can also be a core's local copy of
+// the registers rather than the State8080 itself
+
+// ADD, ADC, ADI, ACI - AC is the carry from bit 3 into bit 4
+template <bool LazyFlags = false, typename State>
+inline void AluAdd(State *state, uint8_t value, uint8_t carry)
+{
+    uint16_t result = state->a + value + carry;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazyAdd, state->a, value, result);
+    }
+    else
+    {
+        state->flags = Flags8080.carry[result] | ((state->a ^ value ^ result) & FlagAC);
+    }
+    state->a = uint8_t(result);
+}
+
+// Shared by SUB, SBB, SUI, SBI, CMP and CPI. The 8080 subtracts by adding the complement,
+// so AC is the carry out of bit 3 of that addition, the inverse of a borrow into bit 4
+template <bool LazyFlags = false, typename State>
+inline uint8_t AluSubtractFlags(State *state, uint8_t value, uint8_t borrow)
+{
+    uint16_t result = (state->a - value - borrow) & 0x1FF;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazySubtract, state->a, value, result);
+    }
+    else
+    {
+        state->flags = Flags8080.carry[result] | (~(state->a ^ value ^ result) & FlagAC);
+    }
+    return uint8_t(result);
+}
+
+template <bool LazyFlags = false, typename State>
+inline void AluSubtract(State *state, uint8_t value, uint8_t borrow)
+{
+    state->a = AluSubtractFlags<LazyFlags>(state, value, borrow);
+}
+
+template <bool LazyFlags = false, typename State>
+inline void AluCompare(State *state, uint8_t value)
+{
+    AluSubtractFlags<LazyFlags>(state, value, 0);
+}
+
+// ANA, ANI - clears CY, AC is the OR of bit 3 of both operands
+template <bool LazyFlags = false, typename State>
+inline void AluAnd(State *state, uint8_t value)
+{
+    uint8_t result = state->a & value;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazyAnd, state->a, value, result);
+    }
+    else
+    {
+        state->flags = Flags8080.zsp[result] | (((state->a | value) & 0x08) << 1);
+    }
+    state->a = result;
+}
+
+// XRA, XRI - clears CY and AC
+template <bool LazyFlags = false, typename State>
+inline void AluXor(State *state, uint8_t value)
+{
+    state->a ^= value;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazyLogic, 0, 0, state->a);
+    }
+    else
+    {
+        state->flags = Flags8080.zsp[state->a];
+    }
+}
+
+// ORA, ORI - clears CY and AC
+template <bool LazyFlags = false, typename State>
+inline void AluOr(State *state, uint8_t value)
+{
+    state->a |= value;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazyLogic, 0, 0, state->a);
+    }
+    else
+    {
+        state->flags = Flags8080.zsp[state->a];
+    }
+}
+
+// INR leaves CY alone, AC is set when the low nibble wraps to 0
+template <bool LazyFlags = false, typename State>
+inline uint8_t AluIncrement(State *state, uint8_t value)
+{
+    value += 1;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazyIncrement, 0, LazyCarry(state), value);
+    }
+    else
+    {
+        state->flags = (state->flags & FlagCY) | Flags8080.zsp[value] | ((value & 0x0F) == 0x00 ? FlagAC : 0);
+    }
+    return value;
+}
+
+// DCR leaves CY alone, AC is clear only when the low nibble has to borrow
+template <bool LazyFlags = false, typename State>
+inline uint8_t AluDecrement(State *state, uint8_t value)
+{
+    value -= 1;
+    if constexpr (LazyFlags)
+    {
+        RecordLazyFlags(state, LazyDecrement, 0, LazyCarry(state), value);
+    }
+    else
+    {
+        state->flags = (state->flags & FlagCY) | Flags8080.zsp[value] | ((value & 0x0F) == 0x0F ? 0 : FlagAC);
+    }
+    return value;
+}
+
+// DAA - adds 6 to each nibble that is past 9 (or carried out) to get back to packed BCD.
+// It reads AC and CY, so lazy flags are always resolved before it runs
+template <typename State>
+inline void AluDecimalAdjust(State *state)
+{
+    uint8_t correction = 0;
+    uint8_t carry = state->flags & FlagCY;
+    uint8_t lowerNibble = state->a & 0x0F;
+    uint8_t upperNibble = state->a >> 4;
+
+    if (lowerNibble > 9 || (state->flags & FlagAC))
+    {
+        correction |= 0x06;
+    }
+    if (upperNibble > 9 || carry || (upperNibble >= 9 && lowerNibble > 9))
+    {
+        correction |= 0x60;
+        carry = FlagCY;
+    }
+    uint8_t result = state->a + correction;
+    state->flags = Flags8080.zsp[result] | ((state->a ^ correction ^ result) & FlagAC) | carry;
+    state->a = result;
+}
+
+// Opcodes that read the flags or change only some of them. In lazy mode the recorded
+// operation has to be turned into real flags before any of these run
+constexpr bool IsFlagReader(int opcode)
+{
+    switch (opcode)
+    {
+    case 0x07: case 0x0F: case 0x17: case 0x1F: // rotates write CY only
+    case 0x09: case 0x19: case 0x29: case 0x39: // DAD writes CY only
+    case 0x27: case 0x37: case 0x3F:            // DAA, STC, CMC
+    case 0xCE: case 0xDE:                       // ACI, SBI
+    case 0xF1: case 0xF5:                       // POP PSW, PUSH PSW
+        return true;
+    }
+    if ((opcode >= 0x88 && opcode <= 0x8F) || (opcode >= 0x98 && opcode <= 0x9F)) // ADC, SBB
+    {
+        return true;
+    }
+    // Jcc, Ccc and Rcc all sit at 0xC0, 0xC2 and 0xC4 plus a multiple of 8
+    if (opcode >= 0xC0)
+    {
+        int low = opcode & 0x07;
+        return low == 0x00 || low == 0x02 || low == 0x04;
+    }
+    return false;
+}
+
+typedef struct FlagReaderTable {
+    bool reads[256];
+} FlagReaderTable;
+
+constexpr FlagReaderTable BuildFlagReaderTable()
+{
+    FlagReaderTable table{};
+    for (int opcode = 0; opcode < 256; opcode++)
+    {
+        table.reads[opcode] = IsFlagReader(opcode);
+    }
+    return table;
+}
+
+inline constexpr FlagReaderTable FlagReaders = BuildFlagReaderTable();
@@ -0,0 +1,629 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "emulator_shell.h"
+#include "alu8080.h"
+#include "lockstep_core.h"
+#include "memory_map.h"
+#include "rom_loader.h"
+#include "../renderer8080/vram_convert.h"
+#if VRAM_CONVERT_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+using namespace std;
+using namespace std::chrono;
+
+// Runs the Space Invaders attract mode on the switch core with eager and with lazy flags,
+// on the threaded core, on the block cache, on the jit and on the recompiled ROM (the switch core
+// again unless a file from the recompiler is built in), and reports instructions per second
+// for each. The faster cores are then replayed frame by frame against the switch core and the
+// state hashes compared after every frame. The lockstep core runs a set of lanes with different
+// inputs, with its scalar loop and with AVX2 where the CPU has it, and each lane is checked
+// against its own switch core machine. The switch core is also run through a flat memory map and
+// the board's map against plain memory, and the cycle each core stamps on the sound hook's OUTs
+// is checked against the switch core's. Every core, lockstep included, also runs a CALL that pushes over its own operand, and RAM is checked to show through
+// its mirrors on machines from MachineMemory. Last the VRAM to framebuffer converters the
+// renderer picks from are timed in cycles per frame and checked against the scalar loop.
+// Usage: benchmark [frames]
+
+typedef struct BenchmarkResult {
+    uint64_t instructions;
+    uint64_t cycles;
+    double seconds;
+    uint32_t checksum;
+} BenchmarkResult;
+
+// Same scheduling as CPU::RunFrame, but counting instructions as it goes
+static uint64_t RunUntilCounting(CPU &cpu, CPU::State8080 *state, uint64_t target)
+{
+    uint64_t instructions = 0;
+    while (state->cycles < target)
+    {
+        if (state->halted)
+        {
+            state->cycles = target;
+            break;
+        }
+        state->cycles += cpu.Emulate8080Codes(state);
+        instructions++;
+    }
+    return instructions;
+}
+
+// FNV-1a over the registers and work ram, used to check both modes end up in the same place
+static uint32_t StateChecksum(CPU::State8080 *state)
+{
+    uint8_t registers[] = {state->a, state->b, state->c, state->d, state->e, state->h, state->l,
+                           uint8_t(state->sp), uint8_t(state->sp >> 8), uint8_t(state->pc), uint8_t(state->pc >> 8),
+                           uint8_t(state->flags & (FlagS | FlagZ | FlagAC | FlagP | FlagCY))};
+    uint32_t hash = 2166136261u;
+    for (uint8_t value : registers)
+    {
+        hash = (hash ^ value) * 16777619u;
+    }
+    for (int address = 0x2000; address < 0x4000; address++)
+    {
+        hash = (hash ^ state->mem[address]) * 16777619u;
+    }
+    return hash;
+}
+
+// Compares a machine with the switch core machine it runs next to, after a frame
+static bool SameState(CPU::State8080 *reference, CPU::State8080 *state)
+{
+    return StateChecksum(reference) == StateChecksum(state) && reference->cycles == state->cycles;
+}
+
+// A machine with the Space Invaders ROM loaded in zeroed memory and a CPU of its own to run it,
+// freed again when it goes out of scope
+struct LoadedMachine {
+    CPU::State8080 *state;
+    CPU cpu;
+
+    LoadedMachine() : state(Init8080())
+    {
+        memset(state->mem, 0, 0x10000);
+        LoadInvadersRom(state);
+    }
+
+    ~LoadedMachine()
+    {
+        free(state->mem);
+        free(state);
+    }
+
+    LoadedMachine(const LoadedMachine &) = delete;
+    LoadedMachine &operator=(const LoadedMachine &) = delete;
+
+    void RunFrame()
+    {
+        cpu.RunFrame(state);
+    }
+};
+
+// Runs a verification frame by frame: runFrame(frame) moves every machine in it on by a frame,
+// then matches() compares them. Returns the first frame they differ after, or -1
+template <typename RunFrame, typename Matches>
+static int FirstMismatch(int frames, RunFrame runFrame, Matches matches)
+{
+    for (int frame = 0; frame < frames; frame++)
+    {
+        runFrame(frame);
+        if (!matches())
+        {
+            return frame;
+        }
+    }
+    return -1;
+}
+
+static BenchmarkResult RunBenchmark(bool lazyFlags, int frames)
+{
+    LoadedMachine machine;
+    CPU::State8080 *state = machine.state;
+    CPU &cpu = machine.cpu;
+    cpu.SetLazyFlags(state, lazyFlags);
+
+    BenchmarkResult result = {};
+    steady_clock::time_point start = steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        uint64_t frameStart = state->cycles - (state->cycles % CPU::CyclesPerFrame);
+        result.instructions += RunUntilCounting(cpu, state, frameStart + CPU::HalfFrameCycles);
+        state->cycles += cpu.GenerateInterrupt(state, 1);
+        result.instructions += RunUntilCounting(cpu, state, frameStart + CPU::CyclesPerFrame);
+        state->cycles += cpu.GenerateInterrupt(state, 2);
+    }
+    result.seconds = duration<double>(steady_clock::now() - start).count();
+    result.cycles = state->cycles;
+
+    ResolveLazyFlags(state);
+    result.checksum = StateChecksum(state);
+    return result;
+}
+
+// The threaded and block cache cores run whole frames through RunFrame and don't count instructions,
+// main takes the count from the switch core run, which must have executed the same code
+static BenchmarkResult RunFrameBenchmark(CPU::CoreType core, int frames)
+{
+    LoadedMachine machine;
+    machine.cpu.SetCore(core);
+
+    BenchmarkResult result = {};
+    steady_clock::time_point start = steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        machine.RunFrame();
+    }
+    result.seconds = duration<double>(steady_clock::now() - start).count();
+    result.cycles = machine.state->cycles;
+    result.checksum = StateChecksum(machine.state);
+    return result;
+}
+
+// Runs the switch core and another core side by side and compares the state hash after every frame.
+// Returns the first frame that differs, or -1
+static int VerifyCore(CPU::CoreType core, int frames)
+{
+    LoadedMachine reference;
+    LoadedMachine machine;
+    machine.cpu.SetCore(core);
+    auto runFrame = [&](int)
+    {
+        reference.RunFrame();
+        machine.RunFrame();
+    };
+    auto matches = [&]() { return SameState(reference.state, machine.state); };
+    return FirstMismatch(frames, runFrame, matches);
+}
+
+// One OUT as the sound hook saw it: the cycle it started on and the sound ports after it
+typedef struct SoundStamp {
+    uint64_t cycles;
+    uint8_t port3;
+    uint8_t port5;
+} SoundStamp;
+
+static void RecordSoundStamp(CPU::State8080 *state, void *context)
+{
+    std::vector<SoundStamp> *stamps = (std::vector<SoundStamp> *)context;
+    stamps->push_back({state->cycles, state->out_port3, state->out_port5});
+}
+
+// Sounds start on the sample their OUT's cycle maps to, so every core has to report the same
+// cycle for each OUT as the switch core. Returns the index of the first OUT that differs, or -1
+static int VerifySoundStamps(CPU::CoreType core, int frames)
+{
+    std::vector<SoundStamp> expected;
+    std::vector<SoundStamp> stamps;
+    LoadedMachine reference;
+    LoadedMachine machine;
+    machine.cpu.SetCore(core);
+    reference.cpu.SetSoundHook(RecordSoundStamp, &expected);
+    machine.cpu.SetSoundHook(RecordSoundStamp, &stamps);
+
+    // both cores finish a frame having made the same OUTs, so only the new ones need checking
+    size_t checked = 0;
+    int badOut = -1;
+    auto runFrame = [&](int)
+    {
+        reference.RunFrame();
+        machine.RunFrame();
+    };
+    auto matches = [&]()
+    {
+        for (; checked < std::max(expected.size(), stamps.size()); checked++)
+        {
+            if (checked >= expected.size() || checked >= stamps.size() || expected[checked].cycles != stamps[checked].cycles ||
+                expected[checked].port3 != stamps[checked].port3 || expected[checked].port5 != stamps[checked].port5)
+            {
+                badOut = int(checked);
+                return false;
+            }
+        }
+        return true;
+    };
+    FirstMismatch(frames, runFrame, matches);
+    return badOut;
+}
+
+// Runs the switch core on plain memory, through a flat MemoryMap and through the board's map
+// side by side and compares the state hash after every frame. The attract mode never writes its
+// ROM or goes near the RAM mirrors, so all three must agree. Returns the first frame that
+// differs and which map it was, or -1
+static int VerifyMemoryMaps(int frames, const char *&badMap)
+{
+    LoadedMachine reference;
+    LoadedMachine flat;
+    LoadedMachine board;
+    MemoryMap flatMap(flat.state->mem);
+    MemoryMap boardMap(board.state->mem);
+    boardMap.MapInvadersBoard();
+    flat.cpu.SetMemoryMap(&flatMap);
+    board.cpu.SetMemoryMap(&boardMap);
+    auto runFrame = [&](int)
+    {
+        reference.RunFrame();
+        flat.RunFrame();
+        board.RunFrame();
+    };
+    auto matches = [&]()
+    {
+        badMap = !SameState(reference.state, flat.state) ? "flat" : !SameState(reference.state, board.state) ? "board" : nullptr;
+        return badMap == nullptr;
+    };
+    return FirstMismatch(frames, runFrame, matches);
+}
+
+// Not a whole number of 8 lane AVX2 blocks, so the last block runs partly masked
+static const int LockstepLanes = 20;
+
+// Port 1 for lockstep lane n: coin, start, then walking and shooting at lane dependent rates,
+// so the lanes split up and have to find each other again
+static uint8_t LaneInput(int lane, int frame)
+{
+    uint8_t port1 = 0;
+    int offset = frame - 3 * lane;
+    if (offset >= 60 && offset < 64)
+    {
+        port1 |= 0x01; // coin
+    }
+    if (offset >= 120 && offset < 124)
+    {
+        port1 |= 0x04; // p1 start
+    }
+    if (offset >= 200)
+    {
+        port1 |= ((offset / (8 + lane % 5)) & 1) ? 0x20 : 0x40; // left or right
+        port1 |= (offset % (16 + lane % 7)) < 2 ? 0x10 : 0;      // shoot
+    }
+    return port1;
+}
+
+// vectorize asks for the AVX2 groups, vectorized says whether the CPU allowed them
+static BenchmarkResult RunLockstepBenchmark(int lanes, int frames, bool vectorize, uint64_t &groupSteps, bool &vectorized)
+{
+    uint8_t rom[MachineMemory::RomSize];
+    LoadInvadersRomImage(rom);
+    LockstepCore lockstep(lanes, rom);
+    lockstep.SetVectorized(vectorize);
+    vectorized = lockstep.Vectorized();
+
+    BenchmarkResult result = {};
+    steady_clock::time_point start = steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            lockstep.LaneState(lane)->port1 = LaneInput(lane, frame);
+        }
+        lockstep.RunFrame();
+    }
+    result.seconds = duration<double>(steady_clock::now() - start).count();
+    result.instructions = lockstep.LaneInstructions();
+    for (int lane = 0; lane < lanes; lane++)
+    {
+        result.cycles += lockstep.LaneState(lane)->cycles;
+    }
+    result.checksum = StateChecksum(lockstep.LaneState(0));
+    groupSteps = lockstep.GroupSteps();
+    return result;
+}
+
+// Runs every lockstep lane next to a switch core machine given the same inputs and compares them
+// after every frame, with the AVX2 groups or the scalar loop. Returns the first frame where a
+// lane differs, or -1
+static int VerifyLockstep(int lanes, int frames, bool vectorize, int &badLane)
+{
+    uint8_t rom[MachineMemory::RomSize];
+    LoadInvadersRomImage(rom);
+    LockstepCore lockstep(lanes, rom);
+    lockstep.SetVectorized(vectorize);
+    std::vector<LoadedMachine> references(lanes);
+    auto runFrame = [&](int frame)
+    {
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            references[lane].state->port1 = LaneInput(lane, frame);
+            lockstep.LaneState(lane)->port1 = LaneInput(lane, frame);
+            references[lane].RunFrame();
+        }
+        lockstep.RunFrame();
+    };
+    auto matches = [&]()
+    {
+        for (badLane = 0; badLane < lanes; badLane++)
+        {
+            if (!SameState(references[badLane].state, lockstep.LaneState(badLane)))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    return FirstMismatch(frames, runFrame, matches);
+}
+
+// A CALL whose push lands on its own operand jumps to the address it read before the push, as the
+// 8080 does. Runs CNC and CALL set up that way on every core and returns the name of the first
+// that goes anywhere else, or nullptr
+static const char *VerifySelfOverwritingCall()
+{
+    // with sp at 0x2304 the pushed return address 0x2302 lands on the operand's high byte and
+    // would turn the target 0x2410 into 0x0210
+    const uint8_t landing[] = {0x3E, 0x5A, 0xC3, 0x12, 0x24}; // MVI A,5A then JMP to itself
+    auto setUp = [&](CPU::State8080 *state, uint8_t opcode)
+    {
+        const uint8_t call[] = {opcode, 0x10, 0x24};
+        memcpy(&state->mem[0x2300], call, sizeof(call));
+        memcpy(&state->mem[0x2410], landing, sizeof(landing));
+        state->pc = 0x2300;
+        state->sp = 0x2304;
+    };
+    auto landed = [](CPU::State8080 *state) { return state->a == 0x5A && state->sp == 0x2302; };
+
+    const CPU::CoreType cores[] = {CPU::SwitchCore, CPU::ThreadedCore, CPU::BlockCacheCore, CPU::JitCore, CPU::RecompiledCore};
+    const char *names[] = {"switch", "threaded", "blocks", "jit", "aot"};
+    const uint8_t opcodes[] = {0xD4, 0xCD}; // CNC with carry clear, CALL
+    for (uint8_t opcode : opcodes)
+    {
+        for (int index = 0; index < 5; index++)
+        {
+            LoadedMachine machine;
+            setUp(machine.state, opcode);
+            machine.cpu.SetCore(cores[index]);
+            machine.RunFrame();
+            if (!landed(machine.state))
+            {
+                return names[index];
+            }
+        }
+        for (int vectorize = 0; vectorize < 2; vectorize++)
+        {
+            uint8_t rom[MachineMemory::RomSize] = {};
+            LockstepCore lockstep(1, rom);
+            lockstep.SetVectorized(vectorize != 0);
+            setUp(lockstep.LaneState(0), opcode);
+            lockstep.LoadLane(0);
+            lockstep.RunFrame();
+            if (!landed(lockstep.LaneState(0)))
+            {
+                return vectorize ? "vectorized lockstep" : "scalar lockstep";
+            }
+        }
+    }
+    return nullptr;
+}
+
+// On a machine from MachineMemory a write to the RAM at 0x2xxx reads back at 0x4xxx, 0x6xxx and
+// every mirror up to 0xExxx, and a write through a mirror lands in the RAM, without touching the
+// machine next to it. The lockstep core gets the same from its own folding, scalar or vectorized
+// and whether or not the host mirrored its lanes. Returns what went wrong, or nullptr
+static const char *VerifyRamMirrors()
+{
+    uint8_t rom[MachineMemory::RomSize] = {};
+    MachineMemory memory(rom);
+    std::vector<bool> mirrored;
+    uint8_t *mem = memory.MapMachines(2, mirrored);
+    uint8_t *neighbour = mem + MachineMemory::Stride;
+    if (!mirrored[0])
+    {
+        printf("the host doesn't mirror RAM here, machines use the page map for it\n");
+    }
+    else
+    {
+        mem[0x2345] = 0x5A;
+        mem[0x6346] = 0xA5;
+        for (int mirror = 0x4000; mirror < 0x10000; mirror += MachineMemory::RamSize)
+        {
+            if (mem[mirror + 0x345] != 0x5A || mem[mirror + 0x346] != 0xA5)
+            {
+                return "a mapped machine";
+            }
+        }
+        if (mem[0x2346] != 0xA5 || neighbour[0x2345] != 0 || neighbour[0x4345] != 0)
+        {
+            return "a mapped machine";
+        }
+    }
+
+    // MVI A,5A  STA 2345  MVI A,0  LDA 6345  STA 4346  JMP to itself
+    const uint8_t program[] = {0x3E, 0x5A, 0x32, 0x45, 0x23, 0x3E, 0x00, 0x3A, 0x45, 0x63, 0x32, 0x46, 0x43, 0xC3, 0x0D, 0x23};
+    for (int vectorize = 0; vectorize < 2; vectorize++)
+    {
+        LockstepCore lockstep(1, rom);
+        lockstep.SetVectorized(vectorize != 0);
+        CPU::State8080 *state = lockstep.LaneState(0);
+        memcpy(&state->mem[0x2300], program, sizeof(program));
+        state->pc = 0x2300;
+        lockstep.LoadLane(0);
+        lockstep.RunFrame();
+        state = lockstep.LaneState(0);
+        if (state->a != 0x5A || state->mem[0x2346] != 0x5A)
+        {
+            return vectorize ? "the vectorized lockstep core" : "the scalar lockstep core";
+        }
+    }
+    return nullptr;
+}
+
+static void PrintResult(const char *mode, const BenchmarkResult &result)
+{
+    printf("%-15s %12llu instructions %8.3f s %8.2f M instructions/s %8.2f emulated MHz  checksum %08x\n",
+           mode, (unsigned long long)result.instructions, result.seconds,
+           result.instructions / result.seconds / 1e6, result.cycles / result.seconds / 1e6, result.checksum);
+}
+
+static uint64_t ReadCycleCounter()
+{
+#if VRAM_CONVERT_X86
+    return __rdtsc();
+#else
+    return uint64_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Converts a whole screen of VRAM the given number of times, returns cycles per screen (on x86,
+// nanoseconds elsewhere) and leaves the last screen in framebuffer
+static double RunVramBenchmark(VramConverter converter, const uint8_t *vram, uint32_t *framebuffer, int screens)
+{
+    static const uint32_t palette[2] = {0xFF000000, 0xFFFFFFFF};
+    uint64_t start = ReadCycleCounter();
+    for (int screen = 0; screen < screens; screen++)
+    {
+        for (int column = 0; column < VramConvertWidth; column += VramConvertBlock)
+        {
+            converter(vram, column, framebuffer, palette);
+        }
+    }
+    return double(ReadCycleCounter() - start) / screens;
+}
+
+// Times every converter this cpu can run on a random screen. Returns false if one of them
+// draws anything different from the scalar loop
+static bool CompareVramConverters(int screens)
+{
+    std::vector<uint8_t> vram(VramConvertWidth * VramConvertHeight / 8);
+    for (uint8_t &value : vram)
+    {
+        value = uint8_t(rand());
+    }
+    const int pixels = VramConvertWidth * VramConvertHeight;
+    std::vector<uint32_t> reference(pixels), framebuffer(pixels);
+    std::vector<VramConverter> converters = {ConvertVramScalar};
+#if VRAM_CONVERT_X86
+    converters.push_back(ConvertVramSse2);
+    if (SelectVramConverter() == ConvertVramAvx2)
+    {
+        converters.push_back(ConvertVramAvx2);
+    }
+#endif
+    double scalarCycles = RunVramBenchmark(ConvertVramScalar, vram.data(), reference.data(), screens);
+    bool same = true;
+    for (VramConverter converter : converters)
+    {
+        std::fill(framebuffer.begin(), framebuffer.end(), 0);
+        double cycles = RunVramBenchmark(converter, vram.data(), framebuffer.data(), screens);
+        printf("vram %-7s %10.0f cycles per frame  %5.1fx the scalar loop\n", VramConverterName(converter), cycles,
+               scalarCycles / cycles);
+        same = same && framebuffer == reference;
+    }
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 6000;
+
+    BenchmarkResult eager = RunBenchmark(false, frames);
+    BenchmarkResult lazy = RunBenchmark(true, frames);
+    BenchmarkResult threaded = RunFrameBenchmark(CPU::ThreadedCore, frames);
+    threaded.instructions = eager.instructions;
+    BenchmarkResult blocks = RunFrameBenchmark(CPU::BlockCacheCore, frames);
+    blocks.instructions = eager.instructions;
+    BenchmarkResult jit = RunFrameBenchmark(CPU::JitCore, frames);
+    jit.instructions = eager.instructions;
+    BenchmarkResult aot = RunFrameBenchmark(CPU::RecompiledCore, frames);
+    aot.instructions = eager.instructions;
+    uint64_t groupSteps = 0;
+    bool vectorized = false;
+    BenchmarkResult lockstep = RunLockstepBenchmark(LockstepLanes, frames, false, groupSteps, vectorized);
+    BenchmarkResult vectorLockstep = RunLockstepBenchmark(LockstepLanes, frames, true, groupSteps, vectorized);
+
+    printf("%d frames of attract mode\n", frames);
+    PrintResult("eager", eager);
+    PrintResult("lazy", lazy);
+    PrintResult("threaded", threaded);
+    PrintResult("blocks", blocks);
+    PrintResult("jit", jit);
+    PrintResult("aot", aot);
+    PrintResult("lockstep scalar", lockstep);
+    if (vectorized)
+    {
+        PrintResult("lockstep avx2", vectorLockstep);
+    }
+    printf("lockstep ran %d lanes with different inputs, %.2f lanes per decoded instruction\n",
+           LockstepLanes, double(lockstep.instructions) / groupSteps);
+    if (eager.checksum != lazy.checksum || eager.instructions != lazy.instructions)
+    {
+        printf("error: eager and lazy flag modes finished in different states\n");
+        return 1;
+    }
+    if (eager.checksum != threaded.checksum || eager.cycles != threaded.cycles)
+    {
+        printf("error: switch and threaded cores finished in different states\n");
+        return 1;
+    }
+    if (eager.checksum != blocks.checksum || eager.cycles != blocks.cycles)
+    {
+        printf("error: switch core and block cache finished in different states\n");
+        return 1;
+    }
+
+    const CPU::CoreType cores[] = {CPU::ThreadedCore, CPU::BlockCacheCore, CPU::JitCore, CPU::RecompiledCore};
+    const char *names[] = {"threaded", "blocks", "jit", "aot"};
+    for (int index = 0; index < 4; index++)
+    {
+        int mismatch = VerifyCore(cores[index], frames);
+        if (mismatch >= 0)
+        {
+            printf("error: %s core state hash differs from the switch core at frame %d\n", names[index], mismatch);
+            return 1;
+        }
+    }
+    for (int vectorize = 0; vectorize < 2; vectorize++)
+    {
+        int badLane = 0;
+        int mismatch = VerifyLockstep(LockstepLanes, frames, vectorize != 0, badLane);
+        if (mismatch >= 0)
+        {
+            printf("error: %s lockstep lane %d state hash differs from the switch core at frame %d\n",
+                   vectorize ? "vectorized" : "scalar", badLane, mismatch);
+            return 1;
+        }
+    }
+    for (int index = 0; index < 4; index++)
+    {
+        int badOut = VerifySoundStamps(cores[index], frames);
+        if (badOut >= 0)
+        {
+            printf("error: %s core stamps OUT %d with a different cycle from the switch core\n", names[index], badOut);
+            return 1;
+        }
+    }
+    const char *badMap = nullptr;
+    int mismatch = VerifyMemoryMaps(frames, badMap);
+    if (mismatch >= 0)
+    {
+        printf("error: switch core through the %s memory map differs from plain memory at frame %d\n", badMap, mismatch);
+        return 1;
+    }
+    printf("per-frame state hashes match the switch core\n");
+    const char *badMirror = VerifyRamMirrors();
+    if (badMirror)
+    {
+        printf("error: RAM doesn't show through its mirrors on %s\n", badMirror);
+        return 1;
+    }
+    const char *badCall = VerifySelfOverwritingCall();
+    if (badCall)
+    {
+        printf("error: %s core doesn't jump to a CALL's operand as read before its push\n", badCall);
+        return 1;
+    }
+    if (!CompareVramConverters(frames))
+    {
+        printf("error: a SIMD VRAM converter draws a different frame from the scalar loop\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,794 @@
+#include <cstddef>
+#include "block_cache.h"
+#include "alu8080.h"
+#include "jit_x64.h"
+
+// Registers are reached through their byte offset inside State8080 so a single handler
+// covers every register combination. Index order is the 8080 encoding: B C D E H L M A
+static const uint8_t RegisterOffset[8] = {
+    offsetof(CPU::State8080, b), offsetof(CPU::State8080, c),
+    offsetof(CPU::State8080, d), offsetof(CPU::State8080, e),
+    offsetof(CPU::State8080, h), offsetof(CPU::State8080, l),
+    0, offsetof(CPU::State8080, a)};
+
+// BC DE HL, the fourth slot (SP or PSW) is handled by separate handlers
+static const uint8_t PairOffset[4] = {
+    offsetof(CPU::State8080, bc), offsetof(CPU::State8080, de),
+    offsetof(CPU::State8080, hl), 0};
+
+static inline uint8_t &Reg(CPU::State8080 *state, uint8_t offset)
+{
+    return reinterpret_cast<uint8_t *>(state)[offset];
+}
+
+// Pair instructions keep the offset of bc, de or hl in dst
+static inline uint16_t &Pair(CPU::State8080 *state, const MicroOp &op)
+{
+    return *reinterpret_cast<uint16_t *>(reinterpret_cast<uint8_t *>(state) + op.dst);
+}
+
+static inline void Write(BlockCache &cache, CPU::State8080 *state, uint16_t address, uint8_t value)
+{
+    state->mem[address] = value;
+    cache.NotifyWrite(address);
+}
+
+static inline void Push(BlockCache &cache, CPU::State8080 *state, uint16_t value)
+{
+    Write(cache, state, uint16_t(state->sp - 1), value >> 8);
+    Write(cache, state, uint16_t(state->sp - 2), value & 0xFF);
+    state->sp -= 2;
+}
+
+// Same return address convention as the other cores: CALL and RST push one byte short of the
+// next instruction and RET adds it back
+static inline void Return(CPU::State8080 *state)
+{
+    state->pc = (state->mem[state->sp] | (state->mem[uint16_t(state->sp + 1)] << 8)) + 1;
+    state->sp += 2;
+}
+
+// Condition index order is the 8080 encoding: NZ Z NC C PO PE P M
+template <int Cond>
+static inline bool Condition(CPU::State8080 *state)
+{
+    static const uint8_t masks[4] = {FlagZ, FlagCY, FlagP, FlagS};
+    bool set = (state->flags & masks[Cond >> 1]) != 0;
+    return (Cond & 1) ? set : !set;
+}
+
+template <int Kind>
+static inline void Alu(CPU::State8080 *state, uint8_t value)
+{
+    switch (Kind)
+    {
+    case 0: AluAdd(state, value, 0); break;
+    case 1: AluAdd(state, value, state->flags & FlagCY); break;
+    case 2: AluSubtract(state, value, 0); break;
+    case 3: AluSubtract(state, value, state->flags & FlagCY); break;
+    case 4: AluAnd(state, value); break;
+    case 5: AluXor(state, value); break;
+    case 6: AluOr(state, value); break;
+    case 7: AluCompare(state, value); break;
+    }
+}
+
+// Handlers. The walker has already pointed pc at the next instruction, so only the
+// control flow handlers touch it
+
+static int OpNop(BlockCache &, CPU::State8080 *, const MicroOp &op)
+{
+    return op.cycles;
+}
+
+static int OpMove(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Reg(state, op.dst) = Reg(state, op.src);
+    return op.cycles;
+}
+
+static int OpMoveFromMemory(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Reg(state, op.dst) = state->mem[state->hl];
+    return op.cycles;
+}
+
+static int OpMoveToMemory(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Write(cache, state, state->hl, Reg(state, op.src));
+    return op.cycles;
+}
+
+static int OpMoveImmediate(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Reg(state, op.dst) = uint8_t(op.operand);
+    return op.cycles;
+}
+
+static int OpMoveImmediateToMemory(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Write(cache, state, state->hl, uint8_t(op.operand));
+    return op.cycles;
+}
+
+static int OpLoadPair(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Pair(state, op) = op.operand;
+    return op.cycles;
+}
+
+static int OpLoadSP(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->sp = op.operand;
+    return op.cycles;
+}
+
+static int OpIncrementPair(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Pair(state, op) += 1;
+    return op.cycles;
+}
+
+static int OpDecrementPair(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Pair(state, op) -= 1;
+    return op.cycles;
+}
+
+static int OpIncrementSP(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->sp += 1;
+    return op.cycles;
+}
+
+static int OpDecrementSP(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->sp -= 1;
+    return op.cycles;
+}
+
+static inline void DoubleAdd(CPU::State8080 *state, uint16_t value)
+{
+    uint32_t result = state->hl + value;
+    state->hl = uint16_t(result);
+    state->flags = (state->flags & ~FlagCY) | (result >> 16);
+}
+
+static int OpDoubleAdd(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    DoubleAdd(state, Pair(state, op));
+    return op.cycles;
+}
+
+static int OpDoubleAddSP(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    DoubleAdd(state, state->sp);
+    return op.cycles;
+}
+
+static int OpStoreIndirect(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Write(cache, state, Pair(state, op), state->a);
+    return op.cycles;
+}
+
+static int OpLoadIndirect(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->a = state->mem[Pair(state, op)];
+    return op.cycles;
+}
+
+static int OpStoreA(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Write(cache, state, op.operand, state->a);
+    return op.cycles;
+}
+
+static int OpLoadA(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->a = state->mem[op.operand];
+    return op.cycles;
+}
+
+static int OpStoreHL(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Write(cache, state, op.operand, state->l);
+    Write(cache, state, uint16_t(op.operand + 1), state->h);
+    return op.cycles;
+}
+
+static int OpLoadHL(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->l = state->mem[op.operand];
+    state->h = state->mem[uint16_t(op.operand + 1)];
+    return op.cycles;
+}
+
+static int OpIncrement(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Reg(state, op.dst) = AluIncrement(state, Reg(state, op.dst));
+    return op.cycles;
+}
+
+static int OpDecrement(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Reg(state, op.dst) = AluDecrement(state, Reg(state, op.dst));
+    return op.cycles;
+}
+
+static int OpIncrementMemory(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    uint16_t address = state->hl;
+    Write(cache, state, address, AluIncrement(state, state->mem[address]));
+    return op.cycles;
+}
+
+static int OpDecrementMemory(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    uint16_t address = state->hl;
+    Write(cache, state, address, AluDecrement(state, state->mem[address]));
+    return op.cycles;
+}
+
+static int OpRotateLeft(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    uint8_t bit = state->a >> 7;
+    state->a = uint8_t(state->a << 1) | bit;
+    state->flags = (state->flags & ~FlagCY) | bit;
+    return op.cycles;
+}
+
+static int OpRotateRight(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    uint8_t bit = state->a & 1;
+    state->a = (state->a >> 1) | uint8_t(bit << 7);
+    state->flags = (state->flags & ~FlagCY) | bit;
+    return op.cycles;
+}
+
+static int OpRotateLeftCarry(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    uint8_t bit = state->a >> 7;
+    state->a = uint8_t(state->a << 1) | (state->flags & FlagCY);
+    state->flags = (state->flags & ~FlagCY) | bit;
+    return op.cycles;
+}
+
+static int OpRotateRightCarry(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    uint8_t bit = state->a & 1;
+    state->a = (state->a >> 1) | uint8_t((state->flags & FlagCY) << 7);
+    state->flags = (state->flags & ~FlagCY) | bit;
+    return op.cycles;
+}
+
+static int OpDecimalAdjust(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    AluDecimalAdjust(state);
+    return op.cycles;
+}
+
+static int OpComplement(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->a = ~state->a;
+    return op.cycles;
+}
+
+static int OpSetCarry(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->flags |= FlagCY;
+    return op.cycles;
+}
+
+static int OpComplementCarry(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->flags ^= FlagCY;
+    return op.cycles;
+}
+
+static int OpHalt(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->halted = true;
+    return op.cycles;
+}
+
+template <int Kind>
+static int OpAluRegister(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Alu<Kind>(state, Reg(state, op.src));
+    return op.cycles;
+}
+
+template <int Kind>
+static int OpAluMemory(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Alu<Kind>(state, state->mem[state->hl]);
+    return op.cycles;
+}
+
+template <int Kind>
+static int OpAluImmediate(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Alu<Kind>(state, uint8_t(op.operand));
+    return op.cycles;
+}
+
+template <int Cond>
+static int OpReturnIf(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    if (Condition<Cond>(state))
+    {
+        Return(state);
+        return op.cycles + 6;
+    }
+    return op.cycles;
+}
+
+template <int Cond>
+static int OpJumpIf(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    if (Condition<Cond>(state))
+    {
+        state->pc = op.operand;
+    }
+    return op.cycles;
+}
+
+// CALL's target is the operand as decoded, from before the push. A push over the CALL's own bytes
+// must not change where it goes, the other cores latch it the same way
+template <int Cond>
+static int OpCallIf(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    if (Condition<Cond>(state))
+    {
+        Push(cache, state, op.address + 2);
+        state->pc = op.operand;
+        return op.cycles + 6;
+    }
+    return op.cycles;
+}
+
+static int OpJump(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->pc = op.operand;
+    return op.cycles;
+}
+
+static int OpCall(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Push(cache, state, op.address + 2);
+    state->pc = op.operand;
+    return op.cycles;
+}
+
+static int OpReturn(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Return(state);
+    return op.cycles;
+}
+
+static int OpRestart(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Push(cache, state, op.address);
+    state->pc = op.operand;
+    return op.cycles;
+}
+
+static int OpPushPair(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Push(cache, state, Pair(state, op));
+    return op.cycles;
+}
+
+static int OpPopPair(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    Pair(state, op) = state->mem[state->sp] | (state->mem[uint16_t(state->sp + 1)] << 8);
+    state->sp += 2;
+    return op.cycles;
+}
+
+static int OpPushPSW(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    Push(cache, state, (state->psw & PswMask) | FlagOne);
+    return op.cycles;
+}
+
+static int OpPopPSW(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->psw = ((state->mem[state->sp] | (state->mem[uint16_t(state->sp + 1)] << 8)) & PswMask) | FlagOne;
+    state->sp += 2;
+    return op.cycles;
+}
+
+static int OpExchangeStack(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    // matches the switch core, which stacks HL - 1 so a later RET lands on HL
+    uint16_t swapped = state->hl - 1;
+    state->l = state->mem[state->sp];
+    state->h = state->mem[uint16_t(state->sp + 1)];
+    Write(cache, state, state->sp, swapped & 0xFF);
+    Write(cache, state, uint16_t(state->sp + 1), swapped >> 8);
+    return op.cycles;
+}
+
+static int OpJumpHL(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->pc = state->hl;
+    return op.cycles;
+}
+
+static int OpExchange(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    uint16_t swap = state->hl;
+    state->hl = state->de;
+    state->de = swap;
+    return op.cycles;
+}
+
+static int OpLoadSPFromHL(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->sp = state->hl;
+    return op.cycles;
+}
+
+static int OpDisableInterrupts(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->int_enable = 0;
+    return op.cycles;
+}
+
+static int OpEnableInterrupts(BlockCache &, CPU::State8080 *state, const MicroOp &op)
+{
+    state->int_enable = 1;
+    return op.cycles;
+}
+
+// IN and OUT go back through the interpreter so the port handlers stay in one place.
+// state->cycles holds the block's start while a block runs, it is moved up to this instruction
+// for the call so a sound port change gets the same cycle stamp as on the switch core
+static int OpInterpret(BlockCache &cache, CPU::State8080 *state, const MicroOp &op)
+{
+    state->pc = op.address;
+    state->cycles += op.offset;
+    int taken = cache.cpu->Emulate8080Codes(state);
+    state->cycles -= op.offset;
+    return taken;
+}
+
+typedef struct DecodeEntry {
+    int (*handler)(BlockCache &cache, CPU::State8080 *state, const MicroOp &op);
+    uint8_t dst;
+    uint8_t src;
+    uint8_t length;
+    bool endsBlock;
+    bool directBranch; // operand is the branch target
+} DecodeEntry;
+
+static DecodeEntry MakeEntry(int (*handler)(BlockCache &, CPU::State8080 *, const MicroOp &), uint8_t length,
+                             uint8_t dst = 0, uint8_t src = 0, bool endsBlock = false, bool directBranch = false)
+{
+    DecodeEntry entry = {handler, dst, src, length, endsBlock, directBranch};
+    return entry;
+}
+
+typedef int (*MicroOpHandler)(BlockCache &, CPU::State8080 *, const MicroOp &);
+
+static const MicroOpHandler AluRegisterHandlers[8] = {
+    OpAluRegister<0>, OpAluRegister<1>, OpAluRegister<2>, OpAluRegister<3>,
+    OpAluRegister<4>, OpAluRegister<5>, OpAluRegister<6>, OpAluRegister<7>};
+static const MicroOpHandler AluMemoryHandlers[8] = {
+    OpAluMemory<0>, OpAluMemory<1>, OpAluMemory<2>, OpAluMemory<3>,
+    OpAluMemory<4>, OpAluMemory<5>, OpAluMemory<6>, OpAluMemory<7>};
+static const MicroOpHandler AluImmediateHandlers[8] = {
+    OpAluImmediate<0>, OpAluImmediate<1>, OpAluImmediate<2>, OpAluImmediate<3>,
+    OpAluImmediate<4>, OpAluImmediate<5>, OpAluImmediate<6>, OpAluImmediate<7>};
+static const MicroOpHandler ReturnIfHandlers[8] = {
+    OpReturnIf<0>, OpReturnIf<1>, OpReturnIf<2>, OpReturnIf<3>,
+    OpReturnIf<4>, OpReturnIf<5>, OpReturnIf<6>, OpReturnIf<7>};
+static const MicroOpHandler JumpIfHandlers[8] = {
+    OpJumpIf<0>, OpJumpIf<1>, OpJumpIf<2>, OpJumpIf<3>,
+    OpJumpIf<4>, OpJumpIf<5>, OpJumpIf<6>, OpJumpIf<7>};
+static const MicroOpHandler CallIfHandlers[8] = {
+    OpCallIf<0>, OpCallIf<1>, OpCallIf<2>, OpCallIf<3>,
+    OpCallIf<4>, OpCallIf<5>, OpCallIf<6>, OpCallIf<7>};
+
+// Works out the handler and operands for an opcode from its bit fields
+static DecodeEntry DecodeOpcode(uint8_t opcode)
+{
+    int dstIndex = (opcode >> 3) & 7;
+    int srcIndex = opcode & 7;
+    int pairIndex = (opcode >> 4) & 3;
+    // offset of bc, de or hl
+    uint8_t pair = PairOffset[pairIndex];
+
+    if (opcode >= 0x40 && opcode < 0x80)
+    {
+        if (opcode == 0x76)
+            return MakeEntry(OpHalt, 1, 0, 0, true);
+        if (dstIndex == 6)
+            return MakeEntry(OpMoveToMemory, 1, 0, RegisterOffset[srcIndex]);
+        if (srcIndex == 6)
+            return MakeEntry(OpMoveFromMemory, 1, RegisterOffset[dstIndex]);
+        return MakeEntry(OpMove, 1, RegisterOffset[dstIndex], RegisterOffset[srcIndex]);
+    }
+    if (opcode >= 0x80 && opcode < 0xC0)
+    {
+        if (srcIndex == 6)
+            return MakeEntry(AluMemoryHandlers[dstIndex], 1);
+        return MakeEntry(AluRegisterHandlers[dstIndex], 1, 0, RegisterOffset[srcIndex]);
+    }
+    if (opcode < 0x40)
+    {
+        switch (opcode & 0x0F)
+        {
+        case 0x00:
+        case 0x08:
+            return MakeEntry(OpNop, 1);
+        case 0x01:
+            return pairIndex == 3 ? MakeEntry(OpLoadSP, 3) : MakeEntry(OpLoadPair, 3, pair);
+        case 0x03:
+            return pairIndex == 3 ? MakeEntry(OpIncrementSP, 1) : MakeEntry(OpIncrementPair, 1, pair);
+        case 0x09:
+            return pairIndex == 3 ? MakeEntry(OpDoubleAddSP, 1) : MakeEntry(OpDoubleAdd, 1, pair);
+        case 0x0B:
+            return pairIndex == 3 ? MakeEntry(OpDecrementSP, 1) : MakeEntry(OpDecrementPair, 1, pair);
+        case 0x04:
+        case 0x0C:
+            return dstIndex == 6 ? MakeEntry(OpIncrementMemory, 1) : MakeEntry(OpIncrement, 1, RegisterOffset[dstIndex]);
+        case 0x05:
+        case 0x0D:
+            return dstIndex == 6 ? MakeEntry(OpDecrementMemory, 1) : MakeEntry(OpDecrement, 1, RegisterOffset[dstIndex]);
+        case 0x06:
+        case 0x0E:
+            return dstIndex == 6 ? MakeEntry(OpMoveImmediateToMemory, 2) : MakeEntry(OpMoveImmediate, 2, RegisterOffset[dstIndex]);
+        }
+        switch (opcode)
+        {
+        case 0x02: return MakeEntry(OpStoreIndirect, 1, pair);
+        case 0x12: return MakeEntry(OpStoreIndirect, 1, pair);
+        case 0x0A: return MakeEntry(OpLoadIndirect, 1, pair);
+        case 0x1A: return MakeEntry(OpLoadIndirect, 1, pair);
+        case 0x22: return MakeEntry(OpStoreHL, 3);
+        case 0x2A: return MakeEntry(OpLoadHL, 3);
+        case 0x32: return MakeEntry(OpStoreA, 3);
+        case 0x3A: return MakeEntry(OpLoadA, 3);
+        case 0x07: return MakeEntry(OpRotateLeft, 1);
+        case 0x0F: return MakeEntry(OpRotateRight, 1);
+        case 0x17: return MakeEntry(OpRotateLeftCarry, 1);
+        case 0x1F: return MakeEntry(OpRotateRightCarry, 1);
+        case 0x27: return MakeEntry(OpDecimalAdjust, 1);
+        case 0x2F: return MakeEntry(OpComplement, 1);
+        case 0x37: return MakeEntry(OpSetCarry, 1);
+        case 0x3F: return MakeEntry(OpComplementCarry, 1);
+        }
+    }
+    // 0xC0 - 0xFF
+    switch (opcode & 0x07)
+    {
+    case 0x00:
+        return MakeEntry(ReturnIfHandlers[dstIndex], 1, 0, 0, true);
+    case 0x02:
+        return MakeEntry(JumpIfHandlers[dstIndex], 3, 0, 0, true, true);
+    case 0x04:
+        return MakeEntry(CallIfHandlers[dstIndex], 3, 0, 0, true, true);
+    case 0x06:
+        return MakeEntry(AluImmediateHandlers[dstIndex], 2);
+    case 0x07:
+        return MakeEntry(OpRestart, 1, 0, 0, true);
+    }
+    switch (opcode)
+    {
+    case 0xC1: case 0xD1: case 0xE1:
+        return MakeEntry(OpPopPair, 1, pair);
+    case 0xC5: case 0xD5: case 0xE5:
+        return MakeEntry(OpPushPair, 1, pair);
+    case 0xF1: return MakeEntry(OpPopPSW, 1);
+    case 0xF5: return MakeEntry(OpPushPSW, 1);
+    case 0xC3: case 0xCB:
+        return MakeEntry(OpJump, 3, 0, 0, true, true);
+    case 0xCD: case 0xDD: case 0xED: case 0xFD:
+        return MakeEntry(OpCall, 3, 0, 0, true, true);
+    case 0xC9: case 0xD9:
+        return MakeEntry(OpReturn, 1, 0, 0, true);
+    case 0xD3: case 0xDB:
+        return MakeEntry(OpInterpret, 2);
+    case 0xE3: return MakeEntry(OpExchangeStack, 1);
+    case 0xE9: return MakeEntry(OpJumpHL, 1, 0, 0, true);
+    case 0xEB: return MakeEntry(OpExchange, 1);
+    case 0xF9: return MakeEntry(OpLoadSPFromHL, 1);
+    case 0xF3: return MakeEntry(OpDisableInterrupts, 1);
+    case 0xFB: return MakeEntry(OpEnableInterrupts, 1);
+    }
+    return MakeEntry(OpNop, 1);
+}
+
+typedef struct DecodeTable {
+    DecodeEntry entries[256];
+    DecodeTable()
+    {
+        for (int opcode = 0; opcode < 256; opcode++)
+        {
+            entries[opcode] = DecodeOpcode(uint8_t(opcode));
+        }
+    }
+} DecodeTable;
+
+static const DecodeTable OpcodeDecoder;
+
+BlockCache::BlockCache()
+{
+    // translated blocks point straight at their MicroOps, so the arena must never move
+    ops.reserve(MaxArenaOps + MaxBlockOps);
+    Flush();
+}
+
+BlockCache::~BlockCache() {}
+
+void BlockCache::SetJit(bool enabled)
+{
+    if (enabled == (jit != nullptr) || (enabled && !JitX64::Supported()))
+    {
+        return;
+    }
+    jit.reset(enabled ? new JitX64() : nullptr);
+    Flush();
+}
+
+void BlockCache::Flush()
+{
+    ops.clear();
+    blocks.clear();
+    if (jit)
+    {
+        jit->Reset();
+    }
+    // block 0 is a placeholder so 0 can mean "not decoded" in blockAt
+    blocks.push_back(DecodedBlock{});
+    blockAt.assign(0x10000, 0);
+    pageBlocks.assign(256, std::vector<uint32_t>());
+    for (int page = 0; page < 256; page++)
+    {
+        codePages[page] = 0;
+    }
+}
+
+void BlockCache::InvalidatePage(int page)
+{
+    for (uint32_t index : pageBlocks[page])
+    {
+        DecodedBlock &block = blocks[index];
+        if (block.valid && blockAt[block.start] == index)
+        {
+            blockAt[block.start] = 0;
+        }
+        block.valid = false;
+    }
+    pageBlocks[page].clear();
+    codePages[page] = 0;
+    invalidated = true;
+}
+
+uint32_t BlockCache::Decode(CPU::State8080 *state, uint16_t start)
+{
+    if (ops.size() > MaxArenaOps)
+    {
+        Flush();
+    }
+
+    DecodedBlock block = {};
+    block.firstOp = uint32_t(ops.size());
+    block.start = start;
+    block.valid = true;
+
+    uint16_t address = start;
+    const DecodeEntry *entry = nullptr;
+    while (block.opCount < MaxBlockOps)
+    {
+        uint8_t opcode = state->mem[address];
+        entry = &OpcodeDecoder.entries[opcode];
+
+        MicroOp op;
+        op.handler = entry->handler;
+        op.address = address;
+        op.length = entry->length;
+        op.next = uint16_t(address + entry->length);
+        op.cycles = CPU::OpcodeCycles[opcode];
+        op.offset = uint16_t(block.cycles);
+        op.opcode = opcode;
+        op.dst = entry->dst;
+        op.src = entry->src;
+        op.operand = 0;
+        if (entry->length == 2)
+        {
+            op.operand = state->mem[uint16_t(address + 1)];
+        }
+        else if (entry->length == 3)
+        {
+            op.operand = state->mem[uint16_t(address + 1)] | (state->mem[uint16_t(address + 2)] << 8);
+        }
+        else if (entry->handler == OpRestart)
+        {
+            op.operand = opcode & 0x38;
+        }
+        ops.push_back(op);
+        block.opCount++;
+        block.cycles += op.cycles;
+        address = op.next;
+        if (entry->endsBlock)
+        {
+            break;
+        }
+    }
+    block.fallThrough = address;
+    block.branchTarget = entry->directBranch ? ops.back().operand : address;
+
+    uint32_t index = uint32_t(blocks.size());
+    blocks.push_back(block);
+    blockAt[start] = index;
+
+    // remember every page the block's bytes sit in so a write there drops it
+    uint16_t last = uint16_t(address - 1);
+    for (int page = start >> 8;; page = (page + 1) & 0xFF)
+    {
+        pageBlocks[page].push_back(index);
+        codePages[page] = 1;
+        if (page == (last >> 8))
+        {
+            break;
+        }
+    }
+    return index;
+}
+
+// Runs decoded blocks until state->cycles reaches target or the cpu halts.
+// The cycle target is checked after every instruction so timing matches the other cores.
+// A translated block only runs when it is sure to finish before target (a taken Ccc or Rcc
+// at the end costs 6 more), otherwise the walker steps through it, so the jit lands
+// interrupts on exactly the same instruction too
+void BlockCache::Run(CPU &owner, CPU::State8080 *state, uint64_t target)
+{
+    ResolveLazyFlags(state);
+    cpu = &owner;
+
+    uint64_t cycles = state->cycles;
+    while (cycles < target && !state->halted)
+    {
+        if (jit && jit->Full())
+        {
+            Flush();
+        }
+        uint32_t index = blockAt[state->pc];
+        if (index == 0)
+        {
+            index = Decode(state, state->pc);
+        }
+        invalidated = false;
+        if (jit)
+        {
+            DecodedBlock &block = blocks[index];
+            if (!block.native && ++block.runCount == JitThreshold)
+            {
+                block.native = jit->Compile(*this, block);
+            }
+            if (block.native && cycles + block.cycles + 6 <= target)
+            {
+                state->cycles = cycles;
+                cycles += block.native(state);
+                continue;
+            }
+        }
+        const MicroOp *op = &ops[blocks[index].firstOp];
+        const MicroOp *end = op + blocks[index].opCount;
+        state->cycles = cycles;
+        for (; op != end; op++)
+        {
+            state->pc = op->next;
+            cycles += op->handler(*this, state, *op);
+            if (cycles >= target || invalidated)
+            {
+                break;
+            }
+        }
+    }
+    state->cycles = cycles;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "emulator_shell.h"
+
+class BlockCache;
+class JitX64;
+
+// Native translation of a block, returns the cycles it ran
+typedef int (*NativeBlock)(CPU::State8080 *state);
+
+// One pre-decoded instruction. The handler runs it from the decoded fields without
+// touching the opcode bytes again and returns the cycles it took
+typedef struct MicroOp {
+    int (*handler)(BlockCache &cache, CPU::State8080 *state, const struct MicroOp &op);
+    uint16_t operand; // immediate byte, immediate word or RST vector
+    uint16_t address; // where the instruction sits
+    uint16_t next;    // address of the following instruction
+    uint16_t offset;  // cycles from the start of the block to this instruction
+    uint8_t dst;      // State8080 byte offset of the destination register or register pair
+    uint8_t src;      // State8080 byte offset of the source register
+    uint8_t cycles;
+    uint8_t length;
+    uint8_t opcode;
+} MicroOp;
+
+// A run of straight-line code ending at the first jump, call, return, RST, PCHL or HLT
+typedef struct DecodedBlock {
+    uint32_t firstOp;
+    uint16_t opCount;
+    uint16_t start;
+    uint16_t fallThrough;  // address after the last instruction
+    uint16_t branchTarget; // destination of a direct JMP/Jcc/CALL/Ccc ending the block, else fallThrough
+    uint32_t cycles;       // sum of the not-taken cycle counts
+    uint32_t runCount;     // times run through the walker, the jit picks up hot blocks from this
+    NativeBlock native;    // jit translation once the block is hot
+    bool valid;
+} DecodedBlock;
+
+// Third interpreter core, selected with CPU::SetCore(BlockCacheCore).
+// Code is decoded once into MicroOp records the first time it runs and the records are replayed
+// afterwards. The Space Invaders ROM is never written so its blocks live forever; a write into
+// any page holding decoded code throws away the blocks on that page.
+// With the jit turned on (JitCore) hot blocks are also translated to x86-64, see jit_x64.h
+class BlockCache {
+
+    friend class JitX64;
+
+public:
+    BlockCache();
+    ~BlockCache();
+
+    void Run(CPU &cpu, CPU::State8080 *state, uint64_t target);
+
+    void Flush();
+
+    // Turns jit translation on or off, does nothing on builds without jit support
+    void SetJit(bool enabled);
+
+    // Every memory write made while the cache is live goes through here
+    inline void NotifyWrite(uint16_t address)
+    {
+        if (codePages[address >> 8])
+        {
+            InvalidatePage(address >> 8);
+        }
+    }
+
+    CPU *cpu = nullptr; // owner, used for instructions handed back to the interpreter
+
+private:
+    static const int MaxBlockOps = 32;
+    static const size_t MaxArenaOps = 1 << 18;
+    static const uint32_t JitThreshold = 16; // walker runs before a block is translated
+
+    std::vector<MicroOp> ops;
+    std::vector<DecodedBlock> blocks;
+    std::vector<uint32_t> blockAt;                // block index by start address, 0 when not decoded
+    std::vector<std::vector<uint32_t>> pageBlocks; // blocks overlapping each 256 byte page
+    uint8_t codePages[256];
+    bool invalidated = false;
+    std::unique_ptr<JitX64> jit;
+
+    uint32_t Decode(CPU::State8080 *state, uint16_t start);
+    void InvalidatePage(int page);
+};
@@ -1,23 +1,63 @@
+#include <cstring>
 #include <iostream>
 #include "emulator_shell.h"
-#include "emulator_shell.h"
+#include "alu8080.h"
+#include "block_cache.h"
 #include "disassembler.h"
+#include "memory_map.h"
 
 using namespace std;
 
 CPU::CPU() {}
 
-// Return true if even parity and false if odd parity
-bool CPU::Parity(uint16_t number)
-{
-    bool parity = true;
-    while (number)
-    {
-        parity = !parity;
-        number = number & (number - 1);
-    }
-    return parity;
-}
+CPU::~CPU() {}
+
+// Number of clock cycles each opcode takes, from the 8080 data sheet.
+// Conditional calls and returns list their not-taken cost, taking the branch adds 6 cycles
+const uint8_t CPU::OpcodeCycles[256] = {
+    4, 10, 7, 5, 5, 5, 7, 4, 4, 10, 7, 5, 5, 5, 7, 4,     // 0x00 - 0x0F
+    4, 10, 7, 5, 5, 5, 7, 4, 4, 10, 7, 5, 5, 5, 7, 4,     // 0x10 - 0x1F
+    4, 10, 16, 5, 5, 5, 7, 4, 4, 10, 16, 5, 5, 5, 7, 4,   // 0x20 - 0x2F
+    4, 10, 13, 5, 10, 10, 10, 4, 4, 10, 13, 5, 5, 5, 7, 4, // 0x30 - 0x3F
+
+    5, 5, 5, 5, 5, 5, 7, 5, 5, 5, 5, 5, 5, 5, 7, 5, // 0x40 - 0x4F
+    5, 5, 5, 5, 5, 5, 7, 5, 5, 5, 5, 5, 5, 5, 7, 5, // 0x50 - 0x5F
+    5, 5, 5, 5, 5, 5, 7, 5, 5, 5, 5, 5, 5, 5, 7, 5, // 0x60 - 0x6F
+    7, 7, 7, 7, 7, 7, 7, 7, 5, 5, 5, 5, 5, 5, 7, 5, // 0x70 - 0x7F
+
+    4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4, // 0x80 - 0x8F
+    4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4, // 0x90 - 0x9F
+    4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4, // 0xA0 - 0xAF
+    4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4, // 0xB0 - 0xBF
+
+    5, 10, 10, 10, 11, 11, 7, 11, 5, 10, 10, 10, 11, 17, 7, 11, // 0xC0 - 0xCF
+    5, 10, 10, 10, 11, 11, 7, 11, 5, 10, 10, 10, 11, 17, 7, 11, // 0xD0 - 0xDF
+    5, 10, 10, 18, 11, 11, 7, 11, 5, 5, 10, 4, 11, 17, 7, 11,   // 0xE0 - 0xEF
+    5, 10, 10, 4, 11, 11, 7, 11, 5, 5, 10, 4, 11, 17, 7, 11,    // 0xF0 - 0xFF
+};
+
+// Bytes in each instruction, the opcode and its operands
+const uint8_t CPU::OpcodeLengths[256] = {
+    1, 3, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, // 0x00 - 0x0F
+    1, 3, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 2, 1, // 0x10 - 0x1F
+    1, 3, 3, 1, 1, 1, 2, 1, 1, 1, 3, 1, 1, 1, 2, 1, // 0x20 - 0x2F
+    1, 3, 3, 1, 1, 1, 2, 1, 1, 1, 3, 1, 1, 1, 2, 1, // 0x30 - 0x3F
+
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x40 - 0x4F
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x50 - 0x5F
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x60 - 0x6F
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x70 - 0x7F
+
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x80 - 0x8F
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x90 - 0x9F
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0xA0 - 0xAF
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0xB0 - 0xBF
+
+    1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 3, 3, 3, 2, 1, // 0xC0 - 0xCF
+    1, 1, 3, 2, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1, // 0xD0 - 0xDF
+    1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 3, 2, 1, // 0xE0 - 0xEF
+    1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 3, 2, 1, // 0xF0 - 0xFF
+};
 
 // Placeholder function for currently unimplemented instructions
 // Lets us track where we are with getting instruction function up and working
@@ -29,34 +69,13 @@ void CPU::UnimplementedInstruction(State8080 *state)
     exit(1);
 }
 
-CPU::FlagCodes CPU::SetFlags(uint16_t result)
-{
-    FlagCodes ResultCodes;
-    // check if zero flag should be set
-    ResultCodes.z = (result == 0);
-
-    // Sign flag - most significant bit is set
-    ResultCodes.s = 0x80 == (result & 0x80);
-
-    // Parity flag, check if the last bit is set
-    ResultCodes.p = Parity(result);
-
-    // Carry flag will be true if result > 255 (1111 1111)
-    ResultCodes.cy = (result > 0xff);
-
-    // Aux carry is not used in space invaders, pending implementation
-    ResultCodes.ac = 1;
-
-    return ResultCodes;
-}
-
 uint8_t CPU::FlagCalc(CPU::FlagCodes flagState)
 {
     uint8_t FlagValue;
     // calculate Flag register value based on:
     //   |7 |6 |5 |4 |3 |2 |1 |0 |
-    //   |s |z |- |ac|- |p |- |cy|
-    FlagValue = flagState.cy + (flagState.p * 4) + (flagState.ac * 16) + (flagState.z * 64) + (flagState.s * 128);
+    //   |s |z |- |ac|- |p |1 |cy|
+    FlagValue = flagState.cy + FlagOne + (flagState.p * 4) + (flagState.ac * 16) + (flagState.z * 64) + (flagState.s * 128);
     return FlagValue;
 }
 
@@ -65,32 +84,125 @@ bool CPU::IsAuxFlagSet(uint16_t number)
     return true;
 }
 
-void CPU::PerformInterrupt(State8080 *state)
+// Pushes the pc and jumps to the RST vector for interruptNum, the same as the hardware
+// placing an RST instruction on the data bus. Returns the cycles taken (0 if masked)
+int CPU::GenerateInterrupt(State8080 *state, int interruptNum)
 {
-    if (state->int_enable)
+    if (!state->int_enable)
     {
-        state->halted = false;
-        uint16_t valuePC = state->pc - 1;
-        uint8_t upperByte = uint8_t(valuePC >> 8);
-        uint8_t lowerByte = uint8_t(valuePC - (upperByte << 8));
-
-        // push statepc PUSH PC - seperate into upper and lower then set lower to sp - 2 and upper to sp - 1
-        state->mem[state->sp - 2] = lowerByte;
-        state->mem[state->sp - 1] = upperByte;
-        state->pc = 8 * interruptNumber;
-        state->sp -= 2;
-        if (interruptNumber == 1)
+        return 0;
+    }
+    state->halted = false;
+    uint16_t valuePC = state->pc - 1;
+    uint8_t upperByte = uint8_t(valuePC >> 8);
+    uint8_t lowerByte = uint8_t(valuePC - (upperByte << 8));
+
+    // push statepc PUSH PC - seperate into upper and lower then set lower to sp - 2 and upper to sp - 1
+    // the stack address wraps at 64K, with sp below 2 this used to write in front of mem
+    if (memoryMap)
+    {
+        memoryMap->Write(uint16_t(state->sp - 2), lowerByte);
+        memoryMap->Write(uint16_t(state->sp - 1), upperByte);
+    }
+    else
+    {
+        state->mem[uint16_t(state->sp - 2)] = lowerByte;
+        state->mem[uint16_t(state->sp - 1)] = upperByte;
+    }
+    if (blockCache)
+    {
+        blockCache->NotifyWrite(uint16_t(state->sp - 2));
+        blockCache->NotifyWrite(uint16_t(state->sp - 1));
+    }
+    state->pc = 8 * interruptNum;
+    state->sp -= 2;
+    state->int_enable = 0;
+    return OpcodeCycles[0xC7];
+}
+
+void CPU::SetCore(CoreType type)
+{
+    core = type;
+    // other cores write memory without telling the cache, so start over on every switch
+    if (blockCache)
+    {
+        blockCache->Flush();
+    }
+}
+
+// Executes instructions until the cycle counter reaches target.
+// A halted cpu does nothing until the next interrupt, so its clock skips straight to target
+void CPU::RunUntil(State8080 *state, uint64_t target)
+{
+    while (state->cycles < target)
+    {
+        if (state->halted)
+        {
+            state->cycles = target;
+            break;
+        }
+        if (memoryMap)
+        {
+            state->cycles += Emulate8080Codes(state); // only the switch core knows about the map
+        }
+        else if (core == ThreadedCore)
+        {
+            RunThreaded(state, target);
+        }
+        else if (core == BlockCacheCore || core == JitCore)
+        {
+            if (!blockCache)
+            {
+                blockCache.reset(new BlockCache());
+            }
+            blockCache->SetJit(core == JitCore);
+            blockCache->Run(*this, state, target);
+        }
+        else if (core == RecompiledCore)
         {
-            interruptNumber = 2;
+            RunRecompiled(state, target);
         }
         else
         {
-            interruptNumber = 1;
+            state->cycles += Emulate8080Codes(state);
         }
-        state->int_enable = 0;
     }
 }
 
+// The last instruction can overshoot budget by a few cycles, the return value includes them
+int CPU::RunCycles(State8080 *state, int budget)
+{
+    uint64_t startCycles = state->cycles;
+    RunUntil(state, startCycles + budget);
+    return int(state->cycles - startCycles);
+}
+
+// Runs one 60 Hz frame of the arcade board: RST 1 fires when the beam reaches mid-screen
+// and RST 2 at vblank. Frames are aligned to multiples of CyclesPerFrame on the cycle
+// counter, so cycles an instruction runs past the frame end come out of the next frame.
+// Returns the number of cycles executed
+int CPU::RunFrame(State8080 *state)
+{
+    uint64_t startCycles = state->cycles;
+    uint64_t frameStart = startCycles - (startCycles % CyclesPerFrame);
+
+    RunUntil(state, frameStart + HalfFrameCycles);
+    state->cycles += GenerateInterrupt(state, 1);
+    if (interruptHook)
+    {
+        interruptHook(state, 1, interruptContext);
+    }
+
+    RunUntil(state, frameStart + CyclesPerFrame);
+    state->cycles += GenerateInterrupt(state, 2);
+    if (interruptHook)
+    {
+        interruptHook(state, 2, interruptContext);
+    }
+
+    return int(state->cycles - startCycles);
+}
+
 void CPU::HandleInput(State8080 *state, uint8_t port)
 {
     switch (port)
@@ -130,83 +242,123 @@ void CPU::HandleOutput(uint8_t port, uint8_t value, State8080 *state)
     }
 }
 
-void CPU::AudioBootup(){
-    Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096);
+void CPU::SetMemoryMap(MemoryMap *map)
+{
+    memoryMap = map;
+    // the other cores wrote memory directly, anything they cached may be stale under the map
+    if (blockCache)
+    {
+        blockCache->Flush();
+    }
 }
 
-void CPU::AudioTearDown() {
-    //Mix_FreeChunk to get rid of sound effect
-    Mix_CloseAudio();
+void CPU::SetSoundHook(SoundHook hook, void *context)
+{
+    soundHook = hook;
+    soundContext = context;
 }
 
+void CPU::SetInterruptHook(InterruptHook hook, void *context)
+{
+    interruptHook = hook;
+    interruptContext = context;
+}
 
 void CPU::PlayAudio(State8080 *state)
 {
-    if(state->out_port3 != state->out_port3_prev){
-        //UFO sound
-        if((state->out_port3 & 0x1) && !(state->out_port3_prev & 0x1)) {
-            Mix_PlayChannel(1, Mix_LoadWAV("sounds/0.wav"), -1);
-        }
-
-        else if(!(state->out_port3 & 0x1) && (state->out_port3_prev & 0x1)){
-            Mix_HaltChannel(1);
-        }
-        //player shooting
-        if((state->out_port3 & 0x2) && !(state->out_port3_prev & 0x2)){
-            Mix_PlayChannel(2, Mix_LoadWAV("sounds/1.wav"), 0);
-        }
-
-        //player dying
-        if((state->out_port3 & 0x4) && !(state->out_port3_prev & 0x4)){
-            Mix_PlayChannel(3, Mix_LoadWAV("sounds/2.wav"), 0);
-        }
-
-        //Invader dying
-        if((state->out_port3 & 0x8) && !(state->out_port3_prev & 0x8)){
-            Mix_PlayChannel(4, Mix_LoadWAV("sounds/3.wav"), 0);
-        }
-        state->out_port3_prev = state->out_port3;
+    if (soundHook)
+    {
+        soundHook(state, soundContext);
     }
+}
 
-    if(state->out_port5 != state->out_port5_prev){
-        //Invader beepboop #1
-        if((state->out_port5 & 0x1) && !(state->out_port5_prev & 0x1)){
-            Mix_PlayChannel(5, Mix_LoadWAV("sounds/4.wav"), 0);
-        }
-
-        //Invader beepboop #2
-        if((state->out_port5 & 0x2) && !(state->out_port5_prev & 0x2)){
-            Mix_PlayChannel(6, Mix_LoadWAV("sounds/5.wav"), 0);
+bool CPU::CoreFromName(const char *name, CoreType &type)
+{
+    static const char *const names[] = {"switch", "threaded", "blocks", "jit", "aot"};
+    static const CoreType types[] = {SwitchCore, ThreadedCore, BlockCacheCore, JitCore, RecompiledCore};
+    for (int index = 0; index < 5; index++)
+    {
+        if (strcmp(name, names[index]) == 0)
+        {
+            type = types[index];
+            return true;
         }
+    }
+    return false;
+}
 
-        //Invader beepboop #3
-        if((state->out_port5 & 0x4) && !(state->out_port5_prev & 0x4)){
-            Mix_PlayChannel(7, Mix_LoadWAV("sounds/6.wav"), 0);
-        }
+void CPU::SetLazyFlags(State8080 *state, bool enabled)
+{
+    ResolveLazyFlags(state);
+    lazyFlags = enabled;
+}
 
-        //Invader beepboop #4 (?)
-        if((state->out_port5 & 0x8) && !(state->out_port5_prev & 0x8)){
-            Mix_PlayChannel(8, Mix_LoadWAV("sounds/7.wav"), 0);
-        }
+// Runs one instruction with the flag mode selected by SetLazyFlags
+// Returns the number of clock cycles the instruction took
+int CPU::Emulate8080Codes(State8080 *state)
+{
+    if (memoryMap)
+    {
+        return lazyFlags ? Execute8080<true, true>(state) : Execute8080<false, true>(state);
     }
+    if (lazyFlags)
+    {
+        return Execute8080<true, false>(state);
+    }
+    return Execute8080<false, false>(state);
 }
 
 // Function for emulating 8080 opcodes, has case for each of our opcodes
 // Unimplemented instructions will call UnimplementedInstruction function
-int CPU::Emulate8080Codes(State8080 *state)
+// Mapped sends every memory access through memoryMap, otherwise they index state->mem directly
+// and this compiles to the same code as before there was a map
+template <bool LazyFlags, bool Mapped>
+int CPU::Execute8080(State8080 *state)
 {
+    MemoryMap *map = memoryMap;
+    auto ReadByte = [state, map](uint16_t address) -> uint8_t
+    {
+        return Mapped ? map->Read(address) : state->mem[address];
+    };
+    auto WriteByte = [state, map](uint16_t address, uint8_t value)
+    {
+        if (Mapped)
+        {
+            map->Write(address, value);
+        }
+        else
+        {
+            state->mem[address] = value;
+        }
+    };
+
     unsigned char *opcode = &state->mem[state->pc];
+    // the map can put anything at pc, so fetch the instruction through it. Only the bytes it
+    // has are read, a handler or watchpoint on the byte after a short instruction never fires
+    unsigned char fetched[3] = {};
+    if (Mapped)
+    {
+        fetched[0] = map->Read(state->pc);
+        int length = OpcodeLengths[fetched[0]];
+        if (length > 1)
+        {
+            fetched[1] = map->Read(uint16_t(state->pc + 1));
+        }
+        if (length > 2)
+        {
+            fetched[2] = map->Read(uint16_t(state->pc + 2));
+        }
+        opcode = fetched;
+    }
+    int cycles = OpcodeCycles[*opcode];
+    if (LazyFlags && FlagReaders.reads[*opcode])
+    {
+        ResolveLazyFlags(state);
+    }
     // print the opcode before executing
     // Disassemble8080Op(state->mem, state->pc);
     uint32_t result;
-    uint8_t upperdec;
-    uint8_t lowerdec;
-
-    // Combined registers
-    // needs to be calculated at usage time
-    uint16_t bc;
-    uint16_t hl;
-    uint16_t de;
+    uint16_t target; // CALL's operand, read before the push in case the push lands on it
 
     switch (*opcode)
     {
@@ -220,29 +372,19 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x02: // STAX B
-        // to create bc shift bits left by 8, creating an empty 8 right bits.
-        // Add state->c to the right bits with bitwise or.
-        bc = (state->b << 8) | state->c;
-        state->mem[bc] = state->a;
+        WriteByte(state->bc, state->a);
         break;
 
     case 0x03: // INX B
-        bc = (state->b << 8) | state->c;
-        bc += 1;
-        state->b = bc >> 8;                // delete the last 8 bits to get b alone
-        state->c = (bc - (state->b << 8)); // subtract the first 8 bits to get c alone
+        state->bc += 1;
         break;
 
     case 0x04: // INR B
-        state->b += 1;
-        result = state->b;
-        state->f = SetFlags(result);
+        state->b = AluIncrement<LazyFlags>(state, state->b);
         break;
 
     case 0x05: // DCR B
-        state->b -= 1;
-        result = state->b;
-        state->f = SetFlags(result);
+        state->b = AluDecrement<LazyFlags>(state, state->b);
         break;
 
     case 0x06: // MVI B, D8
@@ -262,41 +404,25 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x09: // DAD B
-        bc = (state->b << 8) | state->c;
-        hl = (state->h << 8) | state->l;
-        result = bc + hl;
-        hl = result & 0xffff;
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        result = state->bc + state->hl;
+        state->hl = result & 0xffff;
         state->f.cy = result > 0xffff;
         break;
 
     case 0x0A: // LDAX B
-        bc = (state->b << 8) | state->c;
-        state->a = state->mem[bc];
+        state->a = ReadByte(state->bc);
         break;
 
     case 0x0B: // DCX B
-        bc = (state->b << 8) | state->c;
-        bc -= 1;
-        state->b = bc >> 8;
-        state->c = (bc - (state->b << 8));
+        state->bc -= 1;
         break;
 
     case 0x0C: // INR C
-        state->c += 1;
-        state->f.z = state->c == 0;
-        state->f.s = 0x80 == (state->c & 0x80);
-        state->f.p = Parity(state->c);
-        state->f.ac = 1;
+        state->c = AluIncrement<LazyFlags>(state, state->c);
         break;
 
     case 0x0D: // DCR C
-        state->c -= 1;
-        state->f.z = state->c == 0;
-        state->f.s = 0x80 == (state->c & 0x80);
-        state->f.p = Parity(state->c);
-        state->f.ac = 1;
+        state->c = AluDecrement<LazyFlags>(state, state->c);
         break;
 
     case 0x0E: // MVI C,D8
@@ -322,31 +448,19 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x12: // STAX D
-        de = (state->d << 8) | state->e;
-        state->mem[de] = state->a;
+        WriteByte(state->de, state->a);
         break;
 
     case 0x13: // INX D
-        de = (state->d << 8) | state->e;
-        de += 1;
-        state->d = de >> 8;
-        state->e = (de - (state->d << 8));
+        state->de += 1;
         break;
 
     case 0x14: // INR D
-        state->d += 1;
-        state->f.z = state->d == 0;
-        state->f.s = 0x80 == (state->d & 0x80);
-        state->f.p = Parity(state->d);
-        state->f.ac = (state->d & 0x0F) == 0x00; // Sets AC if lower nibble overflows
+        state->d = AluIncrement<LazyFlags>(state, state->d);
         break;
 
     case 0x15: // DCR D
-        state->d -= 1;
-        state->f.z = state->d == 0;
-        state->f.s = 0x80 == (state->d & 0x80);
-        state->f.p = Parity(state->d);
-        state->f.ac = (state->d & 0x0F) == 0x0F; // Sets AC if lower nibble has to borrow from bit 4
+        state->d = AluDecrement<LazyFlags>(state, state->d);
         break;
 
     case 0x16: // MVI D, d8
@@ -370,41 +484,25 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x19: // DAD D
-        de = (state->d << 8) | state->e;
-        hl = (state->h << 8) | state->l;
-        result = de + hl;
-        hl = result & 0xffff;
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        result = state->de + state->hl;
+        state->hl = result & 0xffff;
         state->f.cy = result > 0xffff;
         break;
 
     case 0x1A: // LDAX D
-        de = (state->d << 8) | state->e;
-        state->a = state->mem[de];
+        state->a = ReadByte(state->de);
         break;
 
     case 0x1B: // DCX D
-        de = (state->d << 8) | state->e;
-        de -= 1;
-        state->d = de >> 8;
-        state->e = (de - (state->d << 8));
+        state->de -= 1;
         break;
 
     case 0x1C: // INR E
-        state->e += 1;
-        state->f.z = state->e == 0;
-        state->f.s = 0x80 == (state->e & 0x80);
-        state->f.p = Parity(state->e);
-        state->f.ac = (state->e & 0x0F) == 0x00; // Sets AC if lower nibble overflows
+        state->e = AluIncrement<LazyFlags>(state, state->e);
         break;
 
     case 0x1D: // DCR E
-        state->e -= 1;
-        state->f.z = state->e == 0;
-        state->f.s = 0x80 == (state->e & 0x80);
-        state->f.p = Parity(state->e);
-        state->f.ac = (state->e & 0x0F) == 0x0F; // Sets AC if lower nibble has to borrow from bit 4
+        state->e = AluDecrement<LazyFlags>(state, state->e);
         break;
 
     case 0x1E: // MVI E, d8
@@ -434,33 +532,22 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x22: // SHLD a16
         result = (opcode[2] << 8) | opcode[1];
-        state->mem[result] = state->l;
+        WriteByte(result, state->l);
         result += 1;
-        state->mem[result] = state->h;
+        WriteByte(result, state->h);
         state->pc += 2;
         break;
 
     case 0x23: // INX H
-        hl = (state->h << 8) | state->l;
-        hl += 1;
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        state->hl += 1;
         break;
 
     case 0x24: // INR H
-        state->h += 1;
-        state->f.z = state->h == 0;
-        state->f.s = 0x80 == (state->h & 0x80);
-        state->f.p = Parity(state->h);
-        state->f.ac = (state->h & 0x0F) == 0x00; // Sets AC if lower nibble overflows
+        state->h = AluIncrement<LazyFlags>(state, state->h);
         break;
 
     case 0x25: // DCR H
-        state->h -= 1;
-        state->f.z = state->h == 0;
-        state->f.s = 0x80 == (state->h & 0x80);
-        state->f.p = Parity(state->h);
-        state->f.ac = (state->h & 0x0F) == 0x0F; // Sets AC if lower nibble has to borrow from bit 4
+        state->h = AluDecrement<LazyFlags>(state, state->h);
         break;
 
     case 0x26: // MVI H, d8
@@ -468,70 +555,36 @@ int CPU::Emulate8080Codes(State8080 *state)
         state->pc += 1;
         break;
 
-    case 0x27: // DAA (DEPENDENT ON AC FLAG, MAKE SURE AC FLAG SET UP RIGHT)
-        lowerdec = state->a & 0x0F;
-
-        if (lowerdec > 9 || state->f.ac == 1)
-        {
-            state->a += 6;
-            state->f.ac = lowerdec > 15;
-        }
-
-        upperdec = state->a >> 4;
-        lowerdec = state->a & 0x0F;
-
-        if (upperdec > 9 || state->f.cy == 1)
-        {
-            upperdec += 6;
-            state->f.cy = upperdec > 15;
-        }
-
-        state->a = upperdec << 4 | lowerdec;
-        state->f.p = Parity(state->a);
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->h & 0x80);
+    case 0x27: // DAA
+        AluDecimalAdjust(state);
         break;
 
     case 0x28:
         break; // NOP
 
     case 0x29: // DAD H
-        hl = (state->h << 8) | state->l;
-        result = hl + hl;
+        result = state->hl + state->hl;
         state->f.cy = (result > 0xffff);
-        hl = result & 0xffff; // we need to strip off any overflow bits
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        state->hl = result & 0xffff; // we need to strip off any overflow bits
         break;
 
     case 0x2A: // LHLD adr
         result = (opcode[2] << 8) | opcode[1];
-        state->l = state->mem[result];
-        state->h = state->mem[result + 1];
+        state->l = ReadByte(result);
+        state->h = ReadByte(result + 1);
         state->pc += 2;
         break;
 
     case 0x2B: // DCX H
-        hl = (state->h << 8) | state->l;
-        hl -= 1;
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        state->hl -= 1;
         break;
 
     case 0x2C: // INR L
-        state->l += 1;
-        state->f.p = Parity(state->l);
-        state->f.z = 0 == state->l;
-        state->f.s = 0x80 == (state->l & 0x80);
-        state->f.ac = 1;
+        state->l = AluIncrement<LazyFlags>(state, state->l);
         break;
 
     case 0x2D: // DCR L
-        state->l -= 1;
-        state->f.p = Parity(state->l);
-        state->f.z = 0 == state->l;
-        state->f.s = 0x80 == (state->l & 0x80);
-        state->f.ac = 1;
+        state->l = AluDecrement<LazyFlags>(state, state->l);
         break;
 
     case 0x2E: // MVI L, D8
@@ -553,7 +606,7 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x32: // STA adr
         result = (opcode[2] << 8) | opcode[1];
-        state->mem[result] = state->a;
+        WriteByte(result, state->a);
         state->pc += 2;
         break;
 
@@ -562,26 +615,15 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x34: // INR M
-        hl = (state->h << 8) | state->l;
-        state->mem[hl] = state->mem[hl] + 1;
-        state->f.p = Parity(state->mem[hl]);
-        state->f.z = 0 == state->mem[hl];
-        state->f.s = 0x8000 == (state->mem[hl] & 0x8000);
-        state->f.ac = 1;
+        WriteByte(state->hl, AluIncrement<LazyFlags>(state, ReadByte(state->hl)));
         break;
 
     case 0x35: // DCR M
-        hl = (state->h << 8) | state->l;
-        state->mem[hl] = state->mem[hl] - 1;
-        state->f.p = Parity(state->mem[hl]);
-        state->f.z = 0 == state->mem[hl];
-        state->f.s = 0x8000 == (state->mem[hl] & 0x8000);
-        state->f.ac = 1;
+        WriteByte(state->hl, AluDecrement<LazyFlags>(state, ReadByte(state->hl)));
         break;
 
     case 0x36: // MVI M,D8
-        hl = (state->h << 8) | state->l;
-        state->mem[hl] = opcode[1];
+        WriteByte(state->hl, opcode[1]);
         state->pc += 1;
         break;
 
@@ -593,17 +635,14 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x39: // DAD SP
-        hl = (state->h << 8) | state->l;
-        result = hl + state->sp;
-        state->f.cy = (hl > 0xffff);
-        hl = result & 0xffff;
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        result = state->hl + state->sp;
+        state->f.cy = (result > 0xffff);
+        state->hl = result & 0xffff;
         break;
 
     case 0x3A: // LDA adr
         result = (opcode[2] << 8) | opcode[1];
-        state->a = state->mem[result];
+        state->a = ReadByte(result);
         state->pc += 2;
         break;
 
@@ -611,18 +650,12 @@ int CPU::Emulate8080Codes(State8080 *state)
         state->sp -= 1;
         break;
 
-    case 0x3C:
-        // INR A
-        state->a += 1;
-        result = state->a;
-        state->f = SetFlags(result);
+    case 0x3C: // INR A
+        state->a = AluIncrement<LazyFlags>(state, state->a);
         break;
 
-    case 0x3D:
-        // DCR A
-        state->a -= 1;
-        result = state->a;
-        state->f = SetFlags(result);
+    case 0x3D: // DCR A
+        state->a = AluDecrement<LazyFlags>(state, state->a);
         break;
 
     case 0x3E:
@@ -669,8 +702,7 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x46:
         // MOV B, M
-        hl = (state->h << 8) | state->l;
-        state->b = state->mem[hl];
+        state->b = ReadByte(state->hl);
         break;
 
     case 0x47:
@@ -710,8 +742,7 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x4E:
         // MOV C, M
-        hl = (state->h << 8) | state->l;
-        state->c = state->mem[hl];
+        state->c = ReadByte(state->hl);
         break;
 
     case 0x4F:
@@ -746,8 +777,7 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0x56:
         // MOV D,M moves the number stored in the address at HL to register D
         // shift H left by 8 bits and do an or operator with L
-        hl = (state->h << 8) | (state->l);
-        state->d = state->mem[hl];
+        state->d = ReadByte(state->hl);
         break;
 
     case 0x57:
@@ -779,8 +809,7 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x5E:
-        hl = (state->h << 8) | (state->l);
-        state->e = state->mem[hl];
+        state->e = ReadByte(state->hl);
         break;
 
     case 0x5F:
@@ -814,8 +843,7 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x66:
         // mov h,m
-        hl = (state->h << 8) | (state->l);
-        state->h = state->mem[hl];
+        state->h = ReadByte(state->hl);
         break;
 
     case 0x67:
@@ -855,8 +883,7 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x6E:
         // mov l,m
-        hl = (state->h << 8) | (state->l);
-        state->l = state->mem[hl];
+        state->l = ReadByte(state->hl);
         break;
 
     case 0x6F:
@@ -866,38 +893,32 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x70:
         // mov m,b  (hl)<-b
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->b;
+        WriteByte(state->hl, state->b);
         break;
 
     case 0x71:
         // mov m,c  (hl)<-c
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->c;
+        WriteByte(state->hl, state->c);
         break;
 
     case 0x72:
         // mov m,d  (hl)<-d
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->d;
+        WriteByte(state->hl, state->d);
         break;
 
     case 0x73:
         // mov m,e  (hl)<-e
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->e;
+        WriteByte(state->hl, state->e);
         break;
 
     case 0x74:
         // mov m,h   (hl)<-h
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->h;
+        WriteByte(state->hl, state->h);
         break;
 
     case 0x75:
         // mov m,l  (hl)<-l
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->l;
+        WriteByte(state->hl, state->l);
         break;
 
     case 0x76:
@@ -906,8 +927,7 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0x77:
         // mov m,a  (hl)<-a     error in opcodes page?
-        hl = (state->h << 8) | (state->l);
-        state->mem[hl] = state->a;
+        WriteByte(state->hl, state->a);
         break;
 
     case 0x78:
@@ -936,1080 +956,280 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0x7E: // MOV A, M
-        hl = (state->h << 8) | state->l;
-        state->a = state->mem[hl];
+        state->a = ReadByte(state->hl);
         break;
 
     case 0x7F: // MOV A, A
         state->a = state->a;
         break;
 
-    case 0x80:                      // ADD B
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->b & 0x0F; // Pulls added register low 4 bit nibble
-
-        result = state->a + state->b;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x80: // ADD B
+        AluAdd<LazyFlags>(state, state->b, 0);
         break;
 
-    case 0x81:                      // ADD C
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->c & 0x0F; // Pulls added register low 4 bit nibble
-
-        result = state->a + state->c;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x81: // ADD C
+        AluAdd<LazyFlags>(state, state->c, 0);
         break;
 
-    case 0x82:                      // ADD D
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->d & 0x0F; // Pulls added register low 4 bit nibble
-
-        result = state->a + state->d;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x82: // ADD D
+        AluAdd<LazyFlags>(state, state->d, 0);
         break;
 
-    case 0x83:                      // ADD E
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->e & 0x0F; // Pulls added register low 4 bit nibble
-
-        result = state->a + state->e;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x83: // ADD E
+        AluAdd<LazyFlags>(state, state->e, 0);
         break;
 
-    case 0x84:                      // ADD H
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->h & 0x0F; // Pulls added register low 4 bit nibble
+    case 0x84: // ADD H
+        AluAdd<LazyFlags>(state, state->h, 0);
+        break;
 
-        result = state->a + state->h;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x85: // ADD L
+        AluAdd<LazyFlags>(state, state->l, 0);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x86: // ADD M
+        AluAdd<LazyFlags>(state, ReadByte(state->hl), 0);
         break;
 
-    case 0x85:                      // ADD L
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->l & 0x0F; // Pulls added register low 4 bit nibble
+    case 0x87: // ADD A
+        AluAdd<LazyFlags>(state, state->a, 0);
+        break;
 
-        result = state->a + state->l;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x88: // ADC B
+        AluAdd<LazyFlags>(state, state->b, state->f.cy);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x89: // ADC C
+        AluAdd<LazyFlags>(state, state->c, state->f.cy);
         break;
 
-    case 0x86: // ADD M
-        hl = (state->h << 8) | state->l;
-        lowerdec = state->a & 0x0F;       // Pulls register A low 4 bit nibble
-        upperdec = state->mem[hl] & 0x0F; // Pulls mem value low 4 bit nibble
+    case 0x8A: // ADC D
+        AluAdd<LazyFlags>(state, state->d, state->f.cy);
+        break;
 
-        result = state->a + state->mem[hl];
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x8B: // ADC E
+        AluAdd<LazyFlags>(state, state->e, state->f.cy);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x8C: // ADC H
+        AluAdd<LazyFlags>(state, state->h, state->f.cy);
         break;
 
-    case 0x87:                      // ADD A
-        lowerdec = state->a & 0x0F; // Pulls register A low 4 bit nibble
-        upperdec = state->a & 0x0F; // Pulls added register low 4 bit nibble
+    case 0x8D: // ADC L
+        AluAdd<LazyFlags>(state, state->l, state->f.cy);
+        break;
 
-        result = state->a + state->a;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x8E: // ADC M
+        AluAdd<LazyFlags>(state, ReadByte(state->hl), state->f.cy);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x8F: // ADC A
+        AluAdd<LazyFlags>(state, state->a, state->f.cy);
         break;
 
-    case 0x88:                                      // ADC B
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->b & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
+    case 0x90: // SUB B
+        AluSubtract<LazyFlags>(state, state->b, 0);
+        break;
 
-        result = state->a + state->b + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x91: // SUB C
+        AluSubtract<LazyFlags>(state, state->c, 0);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x92: // SUB D
+        AluSubtract<LazyFlags>(state, state->d, 0);
         break;
 
-    case 0x89:                                      // ADC C
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->c & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
+    case 0x93: // SUB E
+        AluSubtract<LazyFlags>(state, state->e, 0);
+        break;
 
-        result = state->a + state->c + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x94: // SUB H
+        AluSubtract<LazyFlags>(state, state->h, 0);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x95: // SUB L
+        AluSubtract<LazyFlags>(state, state->l, 0);
         break;
 
-    case 0x8A:                                      // ADC D
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->d & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
+    case 0x96: // SUB M
+        AluSubtract<LazyFlags>(state, ReadByte(state->hl), 0);
+        break;
 
-        result = state->a + state->d + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x97: // SUB A
+        AluSubtract<LazyFlags>(state, state->a, 0);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x98: // SBB B
+        AluSubtract<LazyFlags>(state, state->b, state->f.cy);
         break;
 
-    case 0x8B:                                      // ADC E
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->e & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
+    case 0x99: // SBB C
+        AluSubtract<LazyFlags>(state, state->c, state->f.cy);
+        break;
 
-        result = state->a + state->e + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x9A: // SBB D
+        AluSubtract<LazyFlags>(state, state->d, state->f.cy);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x9B: // SBB E
+        AluSubtract<LazyFlags>(state, state->e, state->f.cy);
         break;
 
-    case 0x8C:                                      // ADC H
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->h & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
+    case 0x9C: // SBB H
+        AluSubtract<LazyFlags>(state, state->h, state->f.cy);
+        break;
+    case 0x9D: // SBB L
+        AluSubtract<LazyFlags>(state, state->l, state->f.cy);
+        break;
 
-        result = state->a + state->h + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0x9E: // SBB M
+        AluSubtract<LazyFlags>(state, ReadByte(state->hl), state->f.cy);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0x9F: // SBB A
+        AluSubtract<LazyFlags>(state, state->a, state->f.cy);
         break;
 
-    case 0x8D:                                      // ADC L
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->l & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
+    case 0xA0: // ANA B
+        AluAnd<LazyFlags>(state, state->b);
+        break;
 
-        result = state->a + state->l + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0xA1: // ANA C
+        AluAnd<LazyFlags>(state, state->c);
+        break;
 
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0xA2: // ANA D
+        AluAnd<LazyFlags>(state, state->d);
         break;
 
-    case 0x8E: // ADC M
-        hl = (state->h << 8) | state->l;
-        lowerdec = state->a & 0x0F;                       // Pulls register A low 4 bit nibble
-        upperdec = (state->mem[hl] & 0x0F) + state->f.cy; // Pulls added mem low 4 bit nibble, adds CY value
-
-        result = state->a + state->mem[hl] + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
-        break;
-
-    case 0x8F:                                      // ADC A
-        lowerdec = state->a & 0x0F;                 // Pulls register A low 4 bit nibble
-        upperdec = (state->a & 0x0F) + state->f.cy; // Pulls added register low 4 bit nibble, adds CY value
-
-        result = state->a + state->a + state->f.cy;
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
-        break;
-
-    case 0x90:                                                               // SUB B
-        result = state->a + (~state->b) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->b) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->b > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x91:                                                               // SUB C
-        result = state->a + (~state->c) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->c) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->c > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x92:                                                               // SUB D
-        result = state->a + (~state->d) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->d) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->d > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x93:                                                               // SUB E
-        result = state->a + (~state->e) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->e) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->e > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x94:                                                               // SUB H
-        result = state->a + (~state->h) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->h) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->h > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x95:                                                               // SUB L
-        result = state->a + (~state->l) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->l) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->l > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0xA3: // ANA E
+        AluAnd<LazyFlags>(state, state->e);
         break;
 
-    case 0x96: // SUB M
-        hl = (state->h << 8) | state->l;
-        result = state->a + (~state->mem[hl]) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->mem[hl]) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->mem[hl] > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x97:                                                               // SUB A
-        result = state->a + (~state->a) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->a) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = 0;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x98:                                                                             // SBB B
-        result = state->a + ~(state->b + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->b + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->b + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->b + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x99:                                                                             // SBB C
-        result = state->a + ~(state->c + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->c + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->c + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->c + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x9A:                                                                             // SBB D
-        result = state->a + ~(state->d + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->d + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->d + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->d + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x9B:                                                                             // SBB E
-        result = state->a + ~(state->e + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->e + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->e + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->e + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x9C:                                                                             // SBB H
-        result = state->a + ~(state->h + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->h + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->h + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->h + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-    case 0x9D:                                                                             // SBB L
-        result = state->a + ~(state->l + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->l + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->l + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->l + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
+    case 0xA4: // ANA H
+        AluAnd<LazyFlags>(state, state->h);
         break;
 
-    case 0x9E: // SBB M
-        hl = (state->h << 8) | state->l;
-        result = state->a + ~(state->mem[hl] + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->mem[hl] + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->mem[hl] + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->mem[hl] + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0x9F:                                                                             // SBB A
-        result = state->a + ~(state->a + state->f.cy) + 1;                                 // 2s complement subtraction, flips state of CY flag
-        state->f.ac = ((state->a & 0x0F) + (~(state->a + state->f.cy) + 1 & 0x0F) > 0x0F); // Apparently they don't bother flipping this
-        state->f.cy = (state->a + state->f.cy) > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = state->a == (state->a + state->f.cy);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-        break;
-
-    case 0xA0:                      // ANA B
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->b & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->b;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
-        break;
-
-    case 0xA1:                      // ANA C
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->c & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->c;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
-        break;
-
-    case 0xA2:                      // ANA D
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->d & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->d;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
-        break;
-
-    case 0xA3:                      // ANA E
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->e & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->e;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
-        break;
-
-    case 0xA4:                      // ANA H
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->h & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->h;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
-        break;
-
-    case 0xA5:                      // ANA L
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->l & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->l;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
+    case 0xA5: // ANA L
+        AluAnd<LazyFlags>(state, state->l);
         break;
 
     case 0xA6: // ANA M
-        hl = (state->h << 8) | state->l;
-        lowerdec = state->a & 0x08;       // Isolate bit 3 from A register
-        upperdec = state->mem[hl] & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->mem[hl];
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
+        AluAnd<LazyFlags>(state, ReadByte(state->hl));
         break;
 
-    case 0xA7:                      // ANA A
-        lowerdec = state->a & 0x08; // Isolate bit 3 from A register
-        upperdec = state->a & 0x08; // Isolate bit 3 from AND register
-
-        state->f.cy = 0;                             // ANA clears carry
-        state->f.ac = 0x08 == (lowerdec | upperdec); // AC flag set to OR of bit 3s from involved registers
-        state->a = state->a & state->a;
-        state->f.z = 0 == state->a;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.p = Parity(state->a);
+    case 0xA7: // ANA A
+        AluAnd<LazyFlags>(state, state->a);
         break;
 
     case 0xA8: // XRA B
-        state->a = state->a ^ state->b;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->b);
         break;
 
     case 0xA9: // XRA C
-        state->a = state->a ^ state->c;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->c);
         break;
 
     case 0xAA: // XRA D
-        state->a = state->a ^ state->d;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->d);
         break;
 
     case 0xAB: // XRA E
-        state->a = state->a ^ state->e;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->e);
         break;
 
     case 0xAC: // XRA H
-        state->a = state->a ^ state->h;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->h);
         break;
 
     case 0xAD: // XRA L
-        state->a = state->a ^ state->l;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->l);
         break;
 
     case 0xAE: // XRA M
-        hl = (state->h << 8) | state->l;
-        state->a = state->a ^ state->mem[hl];
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, ReadByte(state->hl));
         break;
 
     case 0xAF: // XRA A
-        state->a = state->a ^ state->a;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, state->a);
         break;
 
     case 0xB0: // ORA B
-        state->a = state->a | state->b;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->b);
         break;
 
     case 0xB1: // ORA C
-        state->a = state->a | state->c;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->c);
         break;
 
     case 0xB2: // ORA D
-        state->a = state->a | state->d;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->d);
         break;
 
     case 0xB3: // ORA E
-        state->a = state->a | state->e;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->e);
         break;
 
     case 0xB4: // ORA H
-        state->a = state->a | state->h;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->h);
         break;
 
     case 0xB5: // ORA L
-        state->a = state->a | state->l;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->l);
         break;
 
     case 0xB6: // ORA M
-        hl = (state->h << 8) | state->l;
-        state->a = state->a | state->mem[hl];
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, ReadByte(state->hl));
         break;
 
     case 0xB7: // ORA A
-        state->a = state->a | state->a;
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluOr<LazyFlags>(state, state->a);
         break;
 
-    case 0xB8:                                                               // CMP B
-        result = state->a + (~state->b) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->b) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->b > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xB8: // CMP B
+        AluCompare<LazyFlags>(state, state->b);
         break;
 
-    case 0xB9:                                                               // CMP C
-        result = state->a + (~state->c) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->c) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->c > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xB9: // CMP C
+        AluCompare<LazyFlags>(state, state->c);
         break;
 
-    case 0xBA:                                                               // CMP D
-        result = state->a + (~state->d) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->d) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->d > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xBA: // CMP D
+        AluCompare<LazyFlags>(state, state->d);
         break;
 
-    case 0xBB:                                                               // CMP E
-        result = state->a + (~state->e) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->e) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->e > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xBB: // CMP E
+        AluCompare<LazyFlags>(state, state->e);
         break;
 
-    case 0xBC:                                                               // CMP H
-        result = state->a + (~state->h) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->h) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->h > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xBC: // CMP H
+        AluCompare<LazyFlags>(state, state->h);
         break;
 
-    case 0xBD:                                                               // CMP L
-        result = state->a + (~state->l) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->l) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->l > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xBD: // CMP L
+        AluCompare<LazyFlags>(state, state->l);
         break;
 
     case 0xBE: // CMP M
-        hl = (state->h << 8) | state->l;
-        result = state->a + (~state->mem[hl]) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->mem[hl]) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = state->mem[hl] > state->a;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+        AluCompare<LazyFlags>(state, ReadByte(state->hl));
         break;
 
-    case 0xBF:                                                               // CMP A
-        result = state->a + (~state->a) + 1;                                 // 2s complement subtraction
-        state->f.ac = ((state->a & 0x0F) + ((~state->a) & 0x0F) + 1) > 0x0F; // Apparently they don't bother flipping this
-        state->f.cy = 0;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.z = 0 == (result & 0xFF);
-        state->f.p = Parity(result & 0xFF);
+    case 0xBF: // CMP A
+        AluCompare<LazyFlags>(state, state->a);
         break;
 
     case 0xC0: // RNZ
         if (!(state->f.z))
         {
-            state->pc = state->mem[state->sp] | (state->mem[state->sp + 1] << 8);
+            cycles += 6;
+            state->pc = ReadByte(state->sp) | (ReadByte(state->sp + 1) << 8);
             state->sp += 2;
         }
         break;
 
     case 0xC1: // POP B
-        state->c = state->mem[state->sp];
-        state->b = state->mem[state->sp + 1];
+        state->c = ReadByte(state->sp);
+        state->b = ReadByte(state->sp + 1);
         state->sp += 2;
         break;
 
@@ -2033,11 +1253,13 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xC4: // CNZ a16
         if (!(state->f.z))
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2047,31 +1269,20 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xC5: // PUSH B
-        state->mem[state->sp - 1] = state->b;
-        state->mem[state->sp - 2] = state->c;
+        WriteByte(state->sp - 1, state->b);
+        WriteByte(state->sp - 2, state->c);
         state->sp -= 2;
         break;
 
-    case 0xC6:                       // ADI d8
-        lowerdec = state->a & 0x0F;  // Pulls register A low 4 bit nibble
-        upperdec = opcode[1] & 0x0F; // Pulls added register low 4 bit nibble
-
-        result = state->a + opcode[1];
-        state->f.z = (0 == (result & 0xFF)); // Accounts for potential carry out of range of register A
-        state->f.s = (0x80 == (result & 0x80));
-        state->f.cy = (result > 0xFF);
-        state->f.p = Parity(result & 0xFF);
-        state->a = result & 0xFF;
-
-        result = lowerdec + upperdec; // Add lower 4 bit pairs to see if carry from bit 3 into bit 4
-        state->f.ac = result > 15;    // If result greater 4 bit capacity, set AC flag, clears otherwise
+    case 0xC6: // ADI d8
+        AluAdd<LazyFlags>(state, opcode[1], 0);
         state->pc++;
         break;
 
     case 0xC7: // RST 0
         result = state->pc;
-        state->mem[state->sp - 1] = (result >> 8);
-        state->mem[state->sp - 2] = (result & 0xFF);
+        WriteByte(state->sp - 1, (result >> 8));
+        WriteByte(state->sp - 2, (result & 0xFF));
         state->sp -= 2;
         state->pc = 0xFFFF; // Set up to overflow to 0x0000 with end of statement increment
         break;
@@ -2079,13 +1290,14 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xC8: // RZ
         if (state->f.z)
         {
-            state->pc = state->mem[state->sp] | (state->mem[state->sp + 1] << 8);
+            cycles += 6;
+            state->pc = ReadByte(state->sp) | (ReadByte(state->sp + 1) << 8);
             state->sp += 2;
         }
         break;
 
     case 0xC9: // RET
-        state->pc = state->mem[state->sp] | (state->mem[state->sp + 1] << 8);
+        state->pc = ReadByte(state->sp) | (ReadByte(state->sp + 1) << 8);
         state->sp += 2;
         break;
 
@@ -2109,11 +1321,13 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xCC: // CZ a16
         if (state->f.z)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2123,26 +1337,25 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xCD:                                     // CALL a16
+        target = (opcode[2] << 8) | opcode[1];
         result = state->pc + 2;                    // save the address of the next instruction
-        state->mem[state->sp - 1] = (result >> 8); // high-order bits in higher stack addr
-        state->mem[state->sp - 2] = result & 0xff; // low-order bits in lower stack addr
+        WriteByte(state->sp - 1, (result >> 8)); // high-order bits in higher stack addr
+        WriteByte(state->sp - 2, result & 0xff); // low-order bits in lower stack addr
         state->sp -= 2;                            // stack grows downward
-        state->pc = (opcode[2] << 8) | opcode[1];  // Jump to the address immediately after the pc
+        state->pc = target;                        // Jump to the address immediately after the pc
         state->pc--;
 
         break;
 
-    case 0xCE:                                       // ACI d8
-        result = state->a + opcode[1] + state->f.cy; // add accumulator, immediate byte and carry flag
-        state->f = SetFlags(result);                 // set flags
-        state->a = result & 0xff;                    // store lower 8 bits in register A
-        state->pc++;                                 // increment the pointer
+    case 0xCE: // ACI d8
+        AluAdd<LazyFlags>(state, opcode[1], state->f.cy); // add accumulator, immediate byte and carry flag
+        state->pc++;                           // increment the pointer
         break;
 
     case 0xCF:                                     // RST1
         result = state->pc;                        // save the address of the next instruction
-        state->mem[state->sp - 1] = (result >> 8); // high-order bits in higher stack addr
-        state->mem[state->sp - 2] = result & 0xff; // low-order bits in lower stack addr
+        WriteByte(state->sp - 1, (result >> 8)); // high-order bits in higher stack addr
+        WriteByte(state->sp - 2, result & 0xff); // low-order bits in lower stack addr
         state->sp -= 2;                            // stack grows downward
         state->pc = 0x0008;                        // sets pc to 8 multiplied by the number associated with RST (8*1)
         state->pc--;
@@ -2151,15 +1364,16 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xD0: // RNC
         if (!state->f.cy)
         {
-            result = (state->mem[state->sp + 1] << 8) | state->mem[state->sp]; // Construct the return address from Stack
+            cycles += 6;
+            result = (ReadByte(state->sp + 1) << 8) | ReadByte(state->sp); // Construct the return address from Stack
             state->pc = result;                                                // Jump to the return address
             state->sp += 2;                                                    // shorten the stack
         }
         break;
 
     case 0xD1:                                // POP D
-        state->d = state->mem[state->sp + 1]; // high-addr bits in higher order register
-        state->e = state->mem[state->sp];     // low-addr bits in lower order register
+        state->d = ReadByte(state->sp + 1); // high-addr bits in higher order register
+        state->e = ReadByte(state->sp);     // low-addr bits in lower order register
         state->sp += 2;                       // shorten the stack
         break;
 
@@ -2187,11 +1401,13 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xD4: // CNC
         if (!state->f.cy)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2201,22 +1417,20 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xD5:                                // PUSH D
-        state->mem[state->sp - 1] = state->d; // higher register bits to the higher sp
-        state->mem[state->sp - 2] = state->e; // lower register bits to the lower sp
+        WriteByte(state->sp - 1, state->d); // higher register bits to the higher sp
+        WriteByte(state->sp - 2, state->e); // lower register bits to the lower sp
         state->sp -= 2;
         break;
 
-    case 0xD6:                              // SUI d8
-        result = state->a + ~opcode[1] + 1; // two's compliment subtraction
-        state->f = SetFlags(result);        // set the flags
-        state->a = result & 0xff;           // store the bottom 8 bits
+    case 0xD6: // SUI d8
+        AluSubtract<LazyFlags>(state, opcode[1], 0);
         state->pc++;
         break;
 
     case 0xD7:                                     // RST 2
         result = state->pc;                        // Store the address of the next instruction on the stack
-        state->mem[state->sp - 1] = (result >> 8); // store the higher bits of the addr in the higher stack addr
-        state->mem[state->sp - 2] = result & 0xff; // store the lower bits of the address in the lower stack addr
+        WriteByte(state->sp - 1, (result >> 8)); // store the higher bits of the addr in the higher stack addr
+        WriteByte(state->sp - 2, result & 0xff); // store the lower bits of the address in the lower stack addr
         state->sp -= 2;                            // stack grows downward
         state->pc = 0x0010;                        // sets pc to 8 multiplied by the number associated with RST (8*2)
         state->pc--;
@@ -2225,14 +1439,15 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xD8: // RC
         if (state->f.cy)
         {
-            result = (state->mem[state->sp + 1] << 8) | state->mem[state->sp]; // load address from the stack
+            cycles += 6;
+            result = (ReadByte(state->sp + 1) << 8) | ReadByte(state->sp); // load address from the stack
             state->pc = result;
             state->sp += 2;
         }
         break;
 
     case 0xD9:                                                             //*RET
-        result = (state->mem[state->sp + 1] << 8) | state->mem[state->sp]; // load address from the stack
+        result = (ReadByte(state->sp + 1) << 8) | ReadByte(state->sp); // load address from the stack
         state->pc = result;
         state->sp += 2;
         break;
@@ -2258,11 +1473,13 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xDC: // CC A16
         if (state->f.cy)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2272,25 +1489,24 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xDD:                                     //*Call a16
+        target = (opcode[2] << 8) | opcode[1];
         result = state->pc + 2;                    // push the address of the next instruction to the stack
-        state->mem[state->sp - 1] = (result >> 8); // higher 8 bits to the higher sp
-        state->mem[state->sp - 2] = result & 0xff; // lower 8 bits to the lower sp
+        WriteByte(state->sp - 1, (result >> 8)); // higher 8 bits to the higher sp
+        WriteByte(state->sp - 2, result & 0xff); // lower 8 bits to the lower sp
         state->sp -= 2;                            // stack grows downward
-        state->pc = (opcode[2] << 8) | opcode[1];  // jump to address loaded from immediate data
+        state->pc = target;                        // jump to address loaded from immediate data
         state->pc--;
         break;
 
-    case 0xDE:                                              // SBI d8
-        result = state->a + ~(opcode[1] + state->f.cy) + 1; // twos compliment difference of the accumulator and the sum of immediate 8 bits and carry flag
-        state->f = SetFlags(result);                        // set flags
-        state->a = result & 0xff;                           // only store the least significant 8 bits
-        state->pc++;                                        // Increment the pc past immediate data
+    case 0xDE: // SBI d8
+        AluSubtract<LazyFlags>(state, opcode[1], state->f.cy); // difference of the accumulator and the sum of immediate 8 bits and carry flag
+        state->pc++;                              // Increment the pc past immediate data
         break;
 
     case 0xDF:                                     // RST 3
         result = state->pc;                        // Store the address of the next instruction on the stack
-        state->mem[state->sp - 1] = (result >> 8); // store the higher bits of the addr in the higher stack addr
-        state->mem[state->sp - 2] = result & 0xff; // store the lower bits of the address in the lower stack addr
+        WriteByte(state->sp - 1, (result >> 8)); // store the higher bits of the addr in the higher stack addr
+        WriteByte(state->sp - 2, result & 0xff); // store the lower bits of the address in the lower stack addr
         state->sp -= 2;                            // stack grows downward
         state->pc = 0x0018;                        // sets pc to 8 multiplied by the number associated with RST (8*3)
         state->pc--;
@@ -2299,14 +1515,15 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xE0: // RPO - Return if parity flag is odd (cleared)
         if (!state->f.p)
         {
-            state->pc = state->mem[state->sp] | (state->mem[state->sp + 1] << 8);
+            cycles += 6;
+            state->pc = ReadByte(state->sp) | (ReadByte(state->sp + 1) << 8);
             state->sp += 2;
         }
         break;
 
     case 0xE1: //  POP H
-        state->l = state->mem[state->sp];
-        state->h = state->mem[state->sp + 1];
+        state->l = ReadByte(state->sp);
+        state->h = ReadByte(state->sp + 1);
         state->sp += 2;
         break;
 
@@ -2324,27 +1541,26 @@ int CPU::Emulate8080Codes(State8080 *state)
 
     case 0xE3: // XTHL - exchange thing at sp with l and thing at sp+1 with h
         // decrement HL before we stack it
-        hl = (state->h << 8) | state->l;
-        hl--;
-        state->h = hl >> 8;
-        state->l = (hl - (state->h << 8));
+        state->hl--;
 
         result = state->l;
-        state->l = state->mem[state->sp];
-        state->mem[state->sp] = result;
+        state->l = ReadByte(state->sp);
+        WriteByte(state->sp, result);
         result = state->h;
-        state->h = state->mem[state->sp + 1];
-        state->mem[state->sp + 1] = result;
+        state->h = ReadByte(state->sp + 1);
+        WriteByte(state->sp + 1, result);
         break;
 
     case 0xE4: // CPO adr code[2], code[1] - call if parity flag even
         if (!state->f.p)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2354,45 +1570,19 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xE5: // PUSH H
-        state->mem[state->sp - 1] = state->h;
-        state->mem[state->sp - 2] = state->l;
+        WriteByte(state->sp - 1, state->h);
+        WriteByte(state->sp - 2, state->l);
         state->sp = state->sp - 2;
         break;
 
     case 0xE6: // ANI data code[1] - A and opcode[1]. Clears carry and aux carry flags
-        state->a = state->a & opcode[1];
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluAnd<LazyFlags>(state, opcode[1]);
         state->pc++;
         break;
 
     case 0xE7: // RST 4 - transfer control to address 8 * 4
-        state->mem[state->sp - 1] = state->pc >> 8;
-        state->mem[state->sp - 2] = state->pc & 0xff;
+        WriteByte(state->sp - 1, state->pc >> 8);
+        WriteByte(state->sp - 2, state->pc & 0xff);
         state->sp = state->sp - 2;
         state->pc = 0x0020;
         state->pc--;
@@ -2401,14 +1591,14 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xE8: // RPE - Return if parity equal
         if (state->f.p)
         {
-            state->pc = state->mem[state->sp] | (state->mem[state->sp + 1] << 8);
+            cycles += 6;
+            state->pc = ReadByte(state->sp) | (ReadByte(state->sp + 1) << 8);
             state->sp += 2;
         }
         break;
 
     case 0xE9: // PCHL - Jump H and L indirect. Moves H and L to PC
-        hl = (state->h << 8) | state->l;
-        state->pc = hl;
+        state->pc = state->hl;
         state->pc--; // decrement control pointer so it stays at hl
         break;
 
@@ -2425,22 +1615,21 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xEB: // XCHG - exchange d & e with h & l registers
-        result = state->h;
-        state->h = state->d;
-        state->d = result;
-        result = state->l;
-        state->l = state->e;
-        state->e = result;
+        result = state->hl;
+        state->hl = state->de;
+        state->de = result;
         break;
 
     case 0xEC: // CPE adr code[2], code[1] - call if parity flag even
         if (state->f.p)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2450,48 +1639,23 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xED: // CALL adr code[2], code[1]
+        target = (opcode[2] << 8) | opcode[1];
         result = state->pc + 2;
-        state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-        state->mem[state->sp - 2] = (result & 0xFF);
+        WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+        WriteByte(state->sp - 2, (result & 0xFF));
         state->sp = state->sp - 2;
-        state->pc = (opcode[2] << 8) | opcode[1];
+        state->pc = target;
         state->pc--;
         break;
 
     case 0xEE: // XRI data code[1] - exclusive or A with opcode[1]. Clears carry and aux carry flags
-        state->a = state->a ^ opcode[1];
-        if (Parity(state->a))
-        {
-            state->f.p = 1; // set parity flag if 0th bit is 0
-        }
-        else
-        {
-            state->f.p = 0;
-        }
-        if (state->a == 0)
-        {
-            state->f.z = 1; // set zero flag if result is 0
-        }
-        else
-        {
-            state->f.z = 0;
-        }
-        if ((state->a & (1 << 7)) >> 7 == 1)
-        {
-            state->f.s = 1; // set sign flag if most significant bit is set
-        }
-        else
-        {
-            state->f.s = 0;
-        }
-        state->f.cy = 0;
-        state->f.ac = 0;
+        AluXor<LazyFlags>(state, opcode[1]);
         state->pc++;
         break;
 
     case 0xEF: // RST 5 - transfer control to address 8 * 5
-        state->mem[state->sp - 1] = state->pc >> 8;
-        state->mem[state->sp - 2] = state->pc & 0xff;
+        WriteByte(state->sp - 1, state->pc >> 8);
+        WriteByte(state->sp - 2, state->pc & 0xff);
         state->sp = state->sp - 2;
         state->pc = 0x0028;
         state->pc--;
@@ -2500,7 +1664,8 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xF0: // RP - return if positive (sign flag is cleared)
         if (!state->f.s)
         {
-            state->pc = state->mem[state->sp] | (state->mem[state->sp + 1] << 8);
+            cycles += 6;
+            state->pc = ReadByte(state->sp) | (ReadByte(state->sp + 1) << 8);
             state->sp += 2;
         }
         break;
@@ -2508,12 +1673,8 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xF1: // POP PSW
         // Contents of memory location pointed at by SP is used to restore condition flags.
         // cy is 0th bit, p 2nd, ac 4th, z 6th, and s 7th.
-        state->f.cy = (state->mem[state->sp] & (1 << 0)) >> 0;
-        state->f.p = (state->mem[state->sp] & (1 << 2)) >> 2;
-        state->f.ac = (state->mem[state->sp] & (1 << 4)) >> 4;
-        state->f.z = (state->mem[state->sp] & (1 << 6)) >> 6;
-        state->f.s = (state->mem[state->sp] & (1 << 7)) >> 7;
-        state->a = state->mem[state->sp + 1]; // Then the datasheet says to do this
+        state->flags = (ReadByte(state->sp) & (FlagS | FlagZ | FlagAC | FlagP | FlagCY)) | FlagOne;
+        state->a = ReadByte(state->sp + 1); // Then the datasheet says to do this
         state->sp = state->sp + 2;
         break;
 
@@ -2536,11 +1697,13 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xF4: // CP adr
         if (state->f.s == 0)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2550,25 +1713,20 @@ int CPU::Emulate8080Codes(State8080 *state)
         break;
 
     case 0xF5: // PUSH PSW
-        state->mem[state->sp - 2] = FlagCalc(state->f);
-        state->mem[state->sp - 1] = state->a;
+        WriteByte(state->sp - 2, FlagCalc(state->f));
+        WriteByte(state->sp - 1, state->a);
         state->sp -= 2;
         break;
 
     case 0xF6: // ORI D8 (carry bit reset to zero, Zero, Sign, and Parity set)
-        state->a = state->a | opcode[1];
-        state->f.cy = 0;
-        state->f.ac = 0;
-        state->f.s = 0x80 == (state->a & 0x80);
-        state->f.z = 0 == (state->a & 0xFF);
-        state->f.p = Parity(state->a & 0xFF);
+        AluOr<LazyFlags>(state, opcode[1]);
         state->pc += 1;
         break;
 
     case 0xF7:                                     // RST 6
         result = state->pc;                        // Store the address of the next instruction on the stack
-        state->mem[state->sp - 1] = (result >> 8); // store the higher bits of the addr in the higher stack addr
-        state->mem[state->sp - 2] = result & 0xff; // store the lower bits of the address in the lower stack addr
+        WriteByte(state->sp - 1, (result >> 8)); // store the higher bits of the addr in the higher stack addr
+        WriteByte(state->sp - 2, result & 0xff); // store the lower bits of the address in the lower stack addr
         state->sp -= 2;                            // stack grows downward
         state->pc = 0x0030;                        // sets pc to 8 multiplied by the number associated with RST (8*6)
         state->pc--;
@@ -2577,14 +1735,14 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xF8:          // RM
         if (state->f.s) // if sign flag set. Perform RET which pops stack into program counter
         {
-            state->pc = (state->mem[state->sp + 1] << 8) | state->mem[state->sp]; // Jump to the return address
+            cycles += 6;
+            state->pc = (ReadByte(state->sp + 1) << 8) | ReadByte(state->sp); // Jump to the return address
             state->sp += 2;
         }
         break;
 
     case 0xF9: // SPHL
-        hl = (state->h << 8) | state->l;
-        state->sp = hl;
+        state->sp = state->hl;
         break;
 
     case 0xFA: // JM adr (jump if minus)
@@ -2606,11 +1764,13 @@ int CPU::Emulate8080Codes(State8080 *state)
     case 0xFC: // CM adr (CALL if minus)
         if (state->f.s)
         {
+            cycles += 6;
+            target = (opcode[2] << 8) | opcode[1];
             result = state->pc + 2;
-            state->mem[state->sp - 1] = (result >> 8) & 0xFF;
-            state->mem[state->sp - 2] = (result & 0xFF);
+            WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+            WriteByte(state->sp - 2, (result & 0xFF));
             state->sp = state->sp - 2;
-            state->pc = (opcode[2] << 8) | opcode[1];
+            state->pc = target;
             state->pc--;
         }
         else
@@ -2619,24 +1779,25 @@ int CPU::Emulate8080Codes(State8080 *state)
         }
         break;
 
-    case 0xFD: // NOP
+    case 0xFD: //*CALL a16
+        target = (opcode[2] << 8) | opcode[1];
+        result = state->pc + 2;
+        WriteByte(state->sp - 1, (result >> 8) & 0xFF);
+        WriteByte(state->sp - 2, (result & 0xFF));
+        state->sp = state->sp - 2;
+        state->pc = target;
+        state->pc--;
         break;
 
-    case 0xFE:                // CPI D8 - Subtract data from accumulator, set flags with result
-        lowerdec = opcode[1]; // Store value for subtraction
-        state->f.z = state->a == lowerdec;
-        state->f.cy = lowerdec > state->a;
-        result = state->a - lowerdec;
-        state->f.ac = (result & 0x0F) == 0x0F;
-        state->f.s = 0x80 == (result & 0x80);
-        state->f.p = Parity(result & 0xFF);
+    case 0xFE: // CPI D8 - Subtract data from accumulator, set flags with result
+        AluCompare<LazyFlags>(state, opcode[1]);
         state->pc += 1;
         break;
 
     case 0xFF:                                     // RST 7
         result = state->pc;                        // Store the address of the next instruction on the stack
-        state->mem[state->sp - 1] = (result >> 8); // store the higher bits of the addr in the higher stack addr
-        state->mem[state->sp - 2] = result & 0xff; // store the lower bits of the address in the lower stack addr
+        WriteByte(state->sp - 1, (result >> 8)); // store the higher bits of the addr in the higher stack addr
+        WriteByte(state->sp - 2, result & 0xff); // store the lower bits of the address in the lower stack addr
         state->sp -= 2;                            // stack grows downward
         state->pc = 0x0038;                        // sets pc to 8 multiplied by the number associated with RST (8*7)
         state->pc--;
@@ -2650,6 +1811,5 @@ int CPU::Emulate8080Codes(State8080 *state)
     printf("\tA $%02x B $%02x C $%02x D $%02x E $%02x H $%02x L $%02x SP %04x\n",
            state->a, state->b, state->c, state->d,
            state->e, state->h, state->l, state->sp);*/
-    // Potentially short term return, expect failed cases will return 1?
-    return 0;
+    return cycles;
 }
\ No newline at end of file
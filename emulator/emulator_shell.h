@@ -1,35 +1,110 @@
 #pragma once
 
 #include <cstdint>
-#include <SDL_mixer.h>
+#include <memory>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define HOST_BIG_ENDIAN 1
+#else
+#define HOST_BIG_ENDIAN 0
+#endif
+
+// A 16 bit register pair with its high and low 8 bit registers laid over it in host byte order
+#if HOST_BIG_ENDIAN
+#define REGISTER_PAIR(high, low, pair) \
+    union {                            \
+        struct {                       \
+            uint8_t high;              \
+            uint8_t low;               \
+        };                             \
+        uint16_t pair;                 \
+    }
+#else
+#define REGISTER_PAIR(high, low, pair) \
+    union {                            \
+        struct {                       \
+            uint8_t low;               \
+            uint8_t high;              \
+        };                             \
+        uint16_t pair;                 \
+    }
+#endif
+
+class BlockCache;
+class MemoryMap;
 
 class CPU {
 
 public:
     CPU();
+    ~CPU();
+
+// Space Invaders clocks the 8080 at 2 MHz and refreshes the screen at 60 Hz,
+// which gives 33,333 cycles per frame with the mid-screen interrupt half way through
+    static const int ClockSpeed = 2000000;
+    static const int FrameRate = 60;
+    static const int CyclesPerFrame = ClockSpeed / FrameRate;
+    static const int HalfFrameCycles = CyclesPerFrame / 2;
+
+    static const uint8_t OpcodeCycles[256];
+    static const uint8_t OpcodeLengths[256];
+
+// Interpreter cores the frame scheduler can run: the reference opcode switch one
+// instruction at a time, the batch core in threaded_core.cpp, the pre-decoded
+// blocks in block_cache.cpp, those blocks with the hot ones translated by jit_x64.cpp, or the
+// ROM recompiled ahead of time into C++ (recompiled_core.cpp)
+    enum CoreType {
+        SwitchCore,
+        ThreadedCore,
+        BlockCacheCore,
+        JitCore,
+        RecompiledCore,
+    };
 
 // Defines FlagCodes structure for tracking/adjusting flags in F register
-// pad variable for bits 5, 3, and 1 which retain set value (not used)
+// Fields are laid out lowest bit first in the same order as the 8080 PSW byte, so the
+// struct can be read and written as a whole byte through State8080::flags
+// pad variables for bits 5, 3, and 1 which retain set value (not used)
 // bit 5 always 0, bit 3 always 0, bit 1 always 1
     typedef struct FlagCodes {
-        uint8_t s: 1;
-        uint8_t z: 1;
-        uint8_t ac: 1;
-        uint8_t p: 1;
         uint8_t cy: 1;
-        uint8_t pad: 3;
+        uint8_t pad1: 1;
+        uint8_t p: 1;
+        uint8_t pad3: 1;
+        uint8_t ac: 1;
+        uint8_t pad5: 1;
+        uint8_t z: 1;
+        uint8_t s: 1;
     } FlagCodes;
 
 // Defines structure for tracking each of the registers found in Intel's 8080
-// Also includes instance of FlagCodes struct to serve as our f register for flags
+// B/C, D/E and H/L are stored as 16 bit pairs with the 8 bit registers overlaid on their
+// halves, so 16 bit instructions use bc, de and hl directly instead of shifting and
+// splitting. A and the flags make up psw the same way.
+// Also includes instance of FlagCodes struct to serve as our f register for flags,
+// overlaid with the packed byte so table driven flag updates can write all flags at once
     typedef struct State8080 {
-        uint8_t a;
-        uint8_t b;
-        uint8_t c;
-        uint8_t d;
-        uint8_t e;
-        uint8_t h;
-        uint8_t l;
+        REGISTER_PAIR(b, c, bc);
+        REGISTER_PAIR(d, e, de);
+        REGISTER_PAIR(h, l, hl);
+        union {
+            struct {
+#if HOST_BIG_ENDIAN
+                uint8_t a;
+                union {
+                    FlagCodes f;
+                    uint8_t flags;
+                };
+#else
+                union {
+                    FlagCodes f;
+                    uint8_t flags;
+                };
+                uint8_t a;
+#endif
+            };
+            uint16_t psw;
+        };
         uint16_t sp;
         uint16_t pc;
         uint8_t *mem;
@@ -41,30 +116,72 @@ public:
         uint8_t out_port3_prev;
         uint8_t out_port5_prev;
         bool halted;
-        FlagCodes f;
+        uint64_t cycles; // total clock cycles executed since reset
+        // last ALU operation in lazy flag mode, see ResolveLazyFlags in alu8080.h
+        uint8_t lazy_op;
+        uint8_t lazy_lhs;
+        uint8_t lazy_rhs;
+        uint16_t lazy_result;
     } State8080;
 
     void UnimplementedInstruction(State8080 *state);
 
     int Emulate8080Codes(State8080 *state);
 
-    FlagCodes SetFlags(uint16_t result);
+    // Lazy flag mode only records each ALU result and builds the flags when an instruction
+    // reads them. Outside code must call ResolveLazyFlags before looking at state->f
+    void SetLazyFlags(State8080 *state, bool enabled);
 
-    bool Parity(uint16_t number);
+    void SetCore(CoreType type);
 
     uint8_t FlagCalc(FlagCodes flagState);
   
     bool IsAuxFlagSet(uint16_t number);
 
-    void PerformInterrupt(State8080* state);
+    int GenerateInterrupt(State8080* state, int interruptNum);
 
-    static void AudioBootup();
+    // Batch entry points for anything embedding the emulator. RunCycles runs the selected core
+    // for at least budget cycles with no interrupts and returns how many it ran, RunFrame runs one
+    // 60 Hz frame including the mid-screen and vblank interrupts
+    int RunCycles(State8080 *state, int budget);
 
-    static void AudioTearDown();
+    int RunFrame(State8080* state);
 
-private:
-    int interruptNumber = 1;
+    // Sound lives outside the cpu so the core can run with no audio device (see headless.cpp).
+    // The front end installs a hook that looks at the sound ports after every OUT
+    typedef void (*SoundHook)(State8080 *state, void *context);
+
+    void SetSoundHook(SoundHook hook, void *context);
+
+    // Called by RunFrame as the beam reaches mid-screen (interruptNum 1) and vblank (2), right
+    // after the interrupt is raised and whether or not the cpu took it. Lets a front end follow
+    // the emulated raster, e.g. wake the render thread once per frame
+    typedef void (*InterruptHook)(State8080 *state, int interruptNum, void *context);
+
+    void SetInterruptHook(InterruptHook hook, void *context);
 
+    // Sends memory accesses through a page map (memory_map.h) instead of straight to state->mem,
+    // for write protection, mirrors and watchpoints. While a map is set every core runs as the
+    // switch core, the others index state->mem directly. nullptr goes back to plain memory
+    void SetMemoryMap(MemoryMap *map);
+
+    // Maps a --core argument (switch, threaded, blocks, jit, aot) to its CoreType
+    static bool CoreFromName(const char *name, CoreType &type);
+
+private:
+    bool lazyFlags = false;
+    CoreType core = SwitchCore;
+    std::unique_ptr<BlockCache> blockCache; // created the first time BlockCacheCore or JitCore runs
+    bool recompiledChecked = false; // RecompiledCore has compared the loaded ROM with the registered one
+    bool recompiledLoaded = false;
+    MemoryMap *memoryMap = nullptr; // not owned
+    SoundHook soundHook = nullptr; // no hook means OUT to the sound ports is silent
+    void *soundContext = nullptr;
+    InterruptHook interruptHook = nullptr;
+    void *interruptContext = nullptr;
+
+    template <bool LazyFlags, bool Mapped>
+    int Execute8080(State8080 *state);
     uint8_t     shift0          = 0;
     uint8_t     shift1          = 0;
     uint8_t     shift_offset    = 0;
@@ -72,6 +189,9 @@ private:
     void HandleInput(State8080* state, uint8_t port);
     void HandleOutput(uint8_t port, uint8_t value, State8080 *state);
     void PlayAudio(State8080 *state);
+    void RunUntil(State8080 *state, uint64_t target);
+    void RunThreaded(State8080 *state, uint64_t target);
+    void RunRecompiled(State8080 *state, uint64_t target);
 
 
   
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "emulator_shell.h"
+#include "alu8080.h"
+#include "machine_pool.h"
+#include "rom_loader.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Headless build of the emulator for regression and throughput runs on machines with no display
+// or sound device. It links only the cpu cores and the shift register / port hardware in
+// emulator_shell.cpp, no SDL, and runs the attract mode as fast as the selected core allows:
+//   g++ -std=c++17 -O2 -pthread headless.cpp emulator_shell.cpp threaded_core.cpp block_cache.cpp
+//       jit_x64.cpp recompiled_core.cpp machine_pool.cpp machine_memory.cpp memory_map.cpp
+//       rom_loader.cpp disassembler.cpp -o headless
+// Usage, from the directory holding ROM/:
+//   headless [frames] [--core switch|threaded|blocks|jit|aot] [--machines n] [--threads n]
+// With more than one machine they run in a MachinePool and the rates are summed over all of them.
+// The checksum covers the registers and all of memory, so two runs of the same frame count
+// must print the same value whatever the core. Pool machines are checked over the board's 16K,
+// above that is mirrors of their RAM
+
+static uint32_t StateChecksum(CPU::State8080 *state, int memorySize = 0x10000)
+{
+    uint32_t hash = 2166136261u;
+    const uint8_t registers[] = {state->a, state->b, state->c, state->d, state->e, state->h, state->l,
+                                 uint8_t(state->flags & (FlagS | FlagZ | FlagAC | FlagP | FlagCY)),
+                                 uint8_t(state->sp), uint8_t(state->sp >> 8),
+                                 uint8_t(state->pc), uint8_t(state->pc >> 8)};
+    for (uint8_t value : registers)
+    {
+        hash = (hash ^ value) * 16777619u;
+    }
+    for (int address = 0; address < memorySize; address++)
+    {
+        hash = (hash ^ state->mem[address]) * 16777619u;
+    }
+    return hash;
+}
+
+// Every machine runs the attract mode with no input, so they must all end in the same state
+static int RunPool(int machineCount, int threadCount, CPU::CoreType core, const char *coreName, int frames)
+{
+    MachinePool pool(machineCount, threadCount);
+    pool.SetCore(core);
+
+    steady_clock::time_point start = steady_clock::now();
+    pool.RunFrames(frames);
+    double seconds = duration<double>(steady_clock::now() - start).count();
+
+    uint64_t cycles = 0;
+    uint32_t checksum = StateChecksum(pool.GetMachine(0).state, 0x4000);
+    int diverged = 0;
+    for (int index = 0; index < machineCount; index++)
+    {
+        cycles += pool.GetMachine(index).state->cycles;
+        diverged += StateChecksum(pool.GetMachine(index).state, 0x4000) != checksum;
+    }
+
+    printf("%d machines x %d frames on the %s core, %d threads, in %.3f s\n",
+           machineCount, frames, coreName, pool.ThreadCount(), seconds);
+    printf("%.2f emulated MHz  %.1f frames/s  %.1f frames/s per thread  checksum %08x\n",
+           cycles / seconds / 1e6, pool.TotalFrames() / seconds,
+           pool.TotalFrames() / seconds / pool.ThreadCount(), checksum);
+    if (diverged)
+    {
+        printf("error: %d machines finished in a different state from machine 0\n", diverged);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 6000;
+    int machineCount = 1;
+    int threadCount = 0;
+    CPU::CoreType core = CPU::ThreadedCore;
+    const char *coreName = "threaded";
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--core") == 0 && arg + 1 < argc)
+        {
+            if (!CPU::CoreFromName(argv[arg + 1], core))
+            {
+                printf("unknown core %s\n", argv[arg + 1]);
+                return 1;
+            }
+            coreName = argv[++arg];
+        }
+        else if (strcmp(argv[arg], "--machines") == 0 && arg + 1 < argc)
+        {
+            machineCount = std::max(1, atoi(argv[++arg]));
+        }
+        else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+        {
+            threadCount = atoi(argv[++arg]);
+        }
+        else
+        {
+            frames = atoi(argv[arg]);
+        }
+    }
+    if (machineCount > 1)
+    {
+        return RunPool(machineCount, threadCount, core, coreName, frames);
+    }
+
+    CPU cpu_instance;
+    cpu_instance.SetCore(core);
+
+    CPU::State8080 *state = Init8080();
+    uint8_t *mem_start = state->mem;
+    LoadInvadersRom(state);
+
+    steady_clock::time_point start = steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        cpu_instance.RunFrame(state);
+    }
+    double seconds = duration<double>(steady_clock::now() - start).count();
+
+    printf("%d frames on the %s core in %.3f s\n", frames, coreName, seconds);
+    printf("%.2f emulated MHz  %.1f frames/s  %.1fx real time  checksum %08x\n",
+           state->cycles / seconds / 1e6, frames / seconds,
+           frames / seconds / CPU::FrameRate, StateChecksum(state));
+    free(mem_start);
+    return 0;
+}
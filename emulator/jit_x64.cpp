@@ -0,0 +1,416 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "jit_x64.h"
+#include "alu8080.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X64 1
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#endif
+
+// Generated code keeps the State8080 pointer in rbx and the cycles run so far in r12d.
+// State8080 fields are addressed as [rbx + disp8], every field sits below offset 128
+static const uint8_t OffsetA = offsetof(CPU::State8080, a);
+static const uint8_t OffsetH = offsetof(CPU::State8080, h);
+static const uint8_t OffsetL = offsetof(CPU::State8080, l);
+static const uint8_t OffsetDE = offsetof(CPU::State8080, de);
+static const uint8_t OffsetHL = offsetof(CPU::State8080, hl);
+static const uint8_t OffsetSP = offsetof(CPU::State8080, sp);
+static const uint8_t OffsetPC = offsetof(CPU::State8080, pc);
+static const uint8_t OffsetMem = offsetof(CPU::State8080, mem);
+static const uint8_t OffsetIntEnable = offsetof(CPU::State8080, int_enable);
+static const uint8_t OffsetFlags = offsetof(CPU::State8080, flags);
+
+// Non-final instructions that store to memory, the block has to stop if one of them hits its own code
+static bool WritesMemory(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0x02: case 0x12: case 0x22: case 0x32: // STAX, SHLD, STA
+    case 0x34: case 0x35: case 0x36:            // INR M, DCR M, MVI M
+    case 0xC5: case 0xD5: case 0xE5: case 0xF5: // PUSH
+    case 0xE3:                                  // XTHL
+        return true;
+    }
+    return opcode >= 0x70 && opcode <= 0x77 && opcode != 0x76; // MOV M,r
+}
+
+JitX64::JitX64()
+{
+    // mapped read/write and never writable and executable at once, a block's pages are opened
+    // for writing only while it is copied in (see Protect). Hosts that refuse to make the
+    // memory executable at all get no jit and JitCore runs as the block cache
+#if defined(JIT_X64) && defined(_WIN32)
+    code = static_cast<uint8_t *>(VirtualAlloc(nullptr, CodeSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#elif defined(JIT_X64)
+    void *memory = mmap(nullptr, CodeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    code = memory == MAP_FAILED ? nullptr : static_cast<uint8_t *>(memory);
+#endif
+    if (code && !Protect(code, CodeSize, false))
+    {
+        Release();
+    }
+    capacity = code ? CodeSize : 0;
+}
+
+JitX64::~JitX64()
+{
+    Release();
+}
+
+void JitX64::Release()
+{
+#if defined(JIT_X64) && defined(_WIN32)
+    if (code)
+    {
+        VirtualFree(code, 0, MEM_RELEASE);
+    }
+#elif defined(JIT_X64)
+    if (code)
+    {
+        munmap(code, CodeSize);
+    }
+#endif
+    code = nullptr;
+}
+
+// Makes the pages under [start, start + size) read/write, or read/execute
+bool JitX64::Protect(uint8_t *start, size_t size, bool writable)
+{
+#if defined(JIT_X64) && defined(_WIN32)
+    DWORD previous;
+    if (!VirtualProtect(start, size, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &previous))
+    {
+        return false;
+    }
+    if (!writable)
+    {
+        FlushInstructionCache(GetCurrentProcess(), start, size);
+    }
+    return true;
+#elif defined(JIT_X64)
+    static const uintptr_t pageMask = uintptr_t(sysconf(_SC_PAGESIZE)) - 1;
+    uintptr_t first = uintptr_t(start) & ~pageMask;
+    uintptr_t last = (uintptr_t(start) + size + pageMask) & ~pageMask;
+    return mprotect(reinterpret_cast<void *>(first), last - first, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) == 0;
+#else
+    (void)start;
+    (void)size;
+    (void)writable;
+    return false;
+#endif
+}
+
+bool JitX64::Supported()
+{
+#if defined(JIT_X64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void JitX64::Reset()
+{
+    used = 0;
+}
+
+void JitX64::Emit(std::initializer_list<uint8_t> bytes)
+{
+    buffer.insert(buffer.end(), bytes);
+}
+
+void JitX64::Emit16(uint16_t value)
+{
+    Emit({uint8_t(value), uint8_t(value >> 8)});
+}
+
+void JitX64::Emit32(uint32_t value)
+{
+    Emit16(uint16_t(value));
+    Emit16(uint16_t(value >> 16));
+}
+
+void JitX64::Emit64(uint64_t value)
+{
+    Emit32(uint32_t(value));
+    Emit32(uint32_t(value >> 32));
+}
+
+// add r12d, pendingCycles
+void JitX64::FlushCycles()
+{
+    if (pendingCycles)
+    {
+        Emit({0x41, 0x81, 0xC4});
+        Emit32(pendingCycles);
+        pendingCycles = 0;
+    }
+}
+
+// Calls op.handler(cache, state, op) and adds the cycles it returns
+void JitX64::EmitCall(BlockCache &cache, const MicroOp &op)
+{
+    FlushCycles();
+    // mov word [rbx + pc], next - handlers expect pc to already point past the instruction
+    Emit({0x66, 0xC7, 0x43, OffsetPC});
+    Emit16(op.next);
+#if defined(_WIN32)
+    Emit({0x48, 0xB9}); // mov rcx, cache
+    Emit64(uint64_t(&cache));
+    Emit({0x48, 0x89, 0xDA}); // mov rdx, rbx
+    Emit({0x49, 0xB8}); // mov r8, op
+    Emit64(uint64_t(&op));
+#else
+    Emit({0x48, 0xBF}); // mov rdi, cache
+    Emit64(uint64_t(&cache));
+    Emit({0x48, 0x89, 0xDE}); // mov rsi, rbx
+    Emit({0x48, 0xBA}); // mov rdx, op
+    Emit64(uint64_t(&op));
+#endif
+    Emit({0x48, 0xB8}); // mov rax, handler
+    Emit64(uint64_t(op.handler));
+    Emit({0xFF, 0xD0});       // call rax
+    Emit({0x41, 0x01, 0xC4}); // add r12d, eax
+    if (WritesMemory(op.opcode))
+    {
+        Emit({0x48, 0xB8}); // mov rax, &cache.invalidated
+        Emit64(uint64_t(&cache.invalidated));
+        Emit({0x80, 0x38, 0x00}); // cmp byte [rax], 0
+        Emit({0x0F, 0x85});       // jne epilogue
+        exitJumps.push_back(buffer.size());
+        Emit32(0);
+    }
+}
+
+// Native code for the instructions that only touch registers or read memory.
+// Returns false when the instruction has to go through its handler
+bool JitX64::EmitInline(const MicroOp &op)
+{
+    uint8_t opcode = op.opcode;
+    int dstIndex = (opcode >> 3) & 7;
+    int srcIndex = opcode & 7;
+
+    if (opcode >= 0x40 && opcode < 0x80 && dstIndex != 6)
+    {
+        if (srcIndex == 6)
+        {
+            // MOV r,M
+            Emit({0x0F, 0xB7, 0x4B, OffsetHL});  // movzx ecx, word [rbx + hl]
+            Emit({0x48, 0x8B, 0x43, OffsetMem}); // mov rax, [rbx + mem]
+            Emit({0x8A, 0x14, 0x08});            // mov dl, [rax + rcx]
+            Emit({0x88, 0x53, op.dst});          // mov [rbx + dst], dl
+        }
+        else if (op.dst != op.src)
+        {
+            Emit({0x0F, 0xB6, 0x43, op.src}); // movzx eax, byte [rbx + src]
+            Emit({0x88, 0x43, op.dst});       // mov [rbx + dst], al
+        }
+    }
+    else if (opcode < 0x40 && (opcode & 0x07) == 0x06 && dstIndex != 6)
+    {
+        Emit({0xC6, 0x43, op.dst, uint8_t(op.operand)}); // MVI: mov byte [rbx + dst], imm8
+    }
+    else if (opcode < 0x40 && (opcode & 0x07) == 0x00)
+    {
+        // NOP and its undocumented copies
+    }
+    else if (opcode == 0x01 || opcode == 0x11 || opcode == 0x21)
+    {
+        Emit({0x66, 0xC7, 0x43, op.dst}); // LXI: mov word [rbx + pair], imm16
+        Emit16(op.operand);
+    }
+    else if (opcode == 0x31)
+    {
+        Emit({0x66, 0xC7, 0x43, OffsetSP}); // LXI SP
+        Emit16(op.operand);
+    }
+    else if (opcode == 0x03 || opcode == 0x13 || opcode == 0x23 || opcode == 0x0B || opcode == 0x1B || opcode == 0x2B)
+    {
+        // INX, DCX
+        if (opcode & 0x08)
+        {
+            Emit({0x66, 0xFF, 0x4B, op.dst}); // dec word [rbx + pair]
+        }
+        else
+        {
+            Emit({0x66, 0xFF, 0x43, op.dst}); // inc word [rbx + pair]
+        }
+    }
+    else if (opcode == 0x33)
+    {
+        Emit({0x66, 0xFF, 0x43, OffsetSP}); // INX SP: inc word [rbx + sp]
+    }
+    else if (opcode == 0x3B)
+    {
+        Emit({0x66, 0xFF, 0x4B, OffsetSP}); // DCX SP: dec word [rbx + sp]
+    }
+    else if (opcode == 0x0A || opcode == 0x1A)
+    {
+        // LDAX
+        Emit({0x0F, 0xB7, 0x4B, op.dst});    // movzx ecx, word [rbx + pair]
+        Emit({0x48, 0x8B, 0x43, OffsetMem}); // mov rax, [rbx + mem]
+        Emit({0x8A, 0x14, 0x08});            // mov dl, [rax + rcx]
+        Emit({0x88, 0x53, OffsetA});         // mov [rbx + a], dl
+    }
+    else if (opcode == 0x3A || opcode == 0x2A)
+    {
+        // LDA, LHLD
+        Emit({0x48, 0x8B, 0x43, OffsetMem}); // mov rax, [rbx + mem]
+        Emit({0x8A, 0x90});                  // mov dl, [rax + operand]
+        Emit32(op.operand);
+        Emit({0x88, 0x53, opcode == 0x3A ? OffsetA : OffsetL}); // mov [rbx + a or l], dl
+        if (opcode == 0x2A)
+        {
+            Emit({0x8A, 0x90}); // mov dl, [rax + operand + 1]
+            Emit32(uint16_t(op.operand + 1));
+            Emit({0x88, 0x53, OffsetH});
+        }
+    }
+    else if (opcode == 0xEB)
+    {
+        // XCHG swaps the DE and HL words
+        Emit({0x66, 0x8B, 0x43, OffsetDE}); // mov ax, [rbx + de]
+        Emit({0x66, 0x8B, 0x4B, OffsetHL}); // mov cx, [rbx + hl]
+        Emit({0x66, 0x89, 0x4B, OffsetDE}); // mov [rbx + de], cx
+        Emit({0x66, 0x89, 0x43, OffsetHL}); // mov [rbx + hl], ax
+    }
+    else if (opcode == 0xF9 || opcode == 0xE9)
+    {
+        // SPHL, PCHL
+        Emit({0x66, 0x8B, 0x43, OffsetHL}); // mov ax, [rbx + hl]
+        Emit({0x66, 0x89, 0x43, opcode == 0xF9 ? OffsetSP : OffsetPC});
+    }
+    else if (opcode == 0x2F)
+    {
+        Emit({0xF6, 0x53, OffsetA}); // CMA: not byte [rbx + a]
+    }
+    else if (opcode == 0x37)
+    {
+        Emit({0x80, 0x4B, OffsetFlags, FlagCY}); // STC: or byte [rbx + flags], CY
+    }
+    else if (opcode == 0x3F)
+    {
+        Emit({0x80, 0x73, OffsetFlags, FlagCY}); // CMC: xor byte [rbx + flags], CY
+    }
+    else if (opcode == 0xF3 || opcode == 0xFB)
+    {
+        Emit({0xC6, 0x43, OffsetIntEnable, uint8_t(opcode == 0xFB)}); // DI, EI
+    }
+    else if (opcode == 0xC3 || opcode == 0xCB)
+    {
+        Emit({0x66, 0xC7, 0x43, OffsetPC}); // JMP: mov word [rbx + pc], target
+        Emit16(op.operand);
+    }
+    else if (opcode >= 0xC0 && (opcode & 0x07) == 0x02)
+    {
+        // Jcc: fall through to next, then overwrite with the target when the condition holds.
+        // Condition order is NZ Z NC C PO PE P M, odd conditions jump when the flag is set
+        static const uint8_t masks[4] = {FlagZ, FlagCY, FlagP, FlagS};
+        Emit({0x66, 0xC7, 0x43, OffsetPC});
+        Emit16(op.next);
+        Emit({0xF6, 0x43, OffsetFlags, masks[dstIndex >> 1]}); // test byte [rbx + flags], mask
+        Emit({uint8_t((dstIndex & 1) ? 0x74 : 0x75), 0x06});  // jz or jnz over the next store
+        Emit({0x66, 0xC7, 0x43, OffsetPC});
+        Emit16(op.operand);
+    }
+    else
+    {
+        return false;
+    }
+    pendingCycles += op.cycles;
+    return true;
+}
+
+NativeBlock JitX64::Compile(BlockCache &cache, const DecodedBlock &block)
+{
+#if defined(JIT_X64)
+    if (!code || Full())
+    {
+        return nullptr;
+    }
+    buffer.clear();
+    exitJumps.clear();
+    pendingCycles = 0;
+
+    Emit({0x53});                   // push rbx
+    Emit({0x41, 0x54});             // push r12
+    Emit({0x55});                   // push rbp, keeps rsp 16 byte aligned for the calls
+    Emit({0x48, 0x83, 0xEC, 0x20}); // sub rsp, 32 - shadow space on windows
+#if defined(_WIN32)
+    Emit({0x48, 0x89, 0xCB});       // mov rbx, rcx
+#else
+    Emit({0x48, 0x89, 0xFB});       // mov rbx, rdi
+#endif
+    Emit({0x45, 0x31, 0xE4});       // xor r12d, r12d
+
+    const MicroOp *ops = &cache.ops[block.firstOp];
+    bool pcSet = false;
+    for (int index = 0; index < block.opCount; index++)
+    {
+        const MicroOp &op = ops[index];
+        if (EmitInline(op))
+        {
+            pcSet = op.opcode == 0xC3 || op.opcode == 0xCB || op.opcode == 0xE9 ||
+                    (op.opcode >= 0xC0 && (op.opcode & 0x07) == 0x02);
+        }
+        else
+        {
+            EmitCall(cache, op);
+            pcSet = true;
+        }
+    }
+    FlushCycles();
+    if (!pcSet)
+    {
+        Emit({0x66, 0xC7, 0x43, OffsetPC}); // mov word [rbx + pc], fallThrough
+        Emit16(block.fallThrough);
+    }
+
+    size_t epilogue = buffer.size();
+    for (size_t jump : exitJumps)
+    {
+        uint32_t distance = uint32_t(epilogue - (jump + 4));
+        memcpy(&buffer[jump], &distance, 4);
+    }
+    Emit({0x44, 0x89, 0xE0});       // mov eax, r12d
+    Emit({0x48, 0x83, 0xC4, 0x20}); // add rsp, 32
+    Emit({0x5D});                   // pop rbp
+    Emit({0x41, 0x5C});             // pop r12
+    Emit({0x5B});                   // pop rbx
+    Emit({0xC3});                   // ret
+
+    if (buffer.size() > MaxBlockCode)
+    {
+        return nullptr;
+    }
+    // the copy can share its first page with blocks already compiled, nothing runs them until
+    // Compile returns and the page is executable again
+    uint8_t *entry = code + used;
+    if (!Protect(entry, buffer.size(), true))
+    {
+        return nullptr;
+    }
+    memcpy(entry, buffer.data(), buffer.size());
+    if (!Protect(entry, buffer.size(), false))
+    {
+        // the constructor managed this, so the host changed its mind. The blocks on this page
+        // can't run any more either, so there is no safe way on
+        printf("error: the jit couldn't make its code executable again\n");
+        exit(1);
+    }
+    used += (buffer.size() + 15) & ~size_t(15);
+    return reinterpret_cast<NativeBlock>(entry);
+#else
+    (void)cache;
+    (void)block;
+    return nullptr;
+#endif
+}
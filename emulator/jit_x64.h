@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+#include "block_cache.h"
+
+// Translates hot blocks from the block cache into x86-64 machine code (JitCore).
+// Register moves, immediates, 16 bit pair arithmetic, memory reads and jumps become native
+// instructions working on State8080 directly; everything else, including every memory write
+// and IN/OUT, calls the block cache's handler for that MicroOp so the write invalidation and
+// the port handlers stay in one place. The cycles a block ran come back as the return value.
+// On anything other than x86-64 Supported() is false and JitCore runs as BlockCacheCore
+class JitX64 {
+
+public:
+    JitX64();
+    ~JitX64();
+
+    static bool Supported();
+
+    // Returns nullptr when the block can't be translated, the walker keeps running it then
+    NativeBlock Compile(BlockCache &cache, const DecodedBlock &block);
+
+    // Out of room for new code, the owner flushes everything through Reset
+    bool Full() const { return code != nullptr && used + MaxBlockCode > capacity; }
+
+    void Reset();
+
+private:
+    static const size_t CodeSize = 8 << 20;
+    static const size_t MaxBlockCode = 4096;
+
+    uint8_t *code = nullptr; // read/execute, read/write only while a block is copied in
+    size_t capacity = 0;
+    size_t used = 0;
+
+    std::vector<uint8_t> buffer; // block being assembled
+    std::vector<size_t> exitJumps; // rel32 fields to point at the epilogue
+    uint32_t pendingCycles = 0; // cycles of inlined instructions not yet added to the counter
+
+    void Release();
+    bool Protect(uint8_t *start, size_t size, bool writable);
+    void Emit(std::initializer_list<uint8_t> bytes);
+    void Emit16(uint16_t value);
+    void Emit32(uint32_t value);
+    void Emit64(uint64_t value);
+    void FlushCycles();
+    void EmitCall(BlockCache &cache, const MicroOp &op);
+    bool EmitInline(const MicroOp &op);
+};
@@ -0,0 +1,1292 @@
+#include <algorithm>
+#include <cstring>
+#include "lockstep_core.h"
+#include "alu8080.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LOCKSTEP_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#else
+#define LOCKSTEP_AVX2 0
+#endif
+
+// The ALU helpers in alu8080.h only need a and flags, so each lane gets run through them with
+// its two bytes copied into one of these
+typedef struct LaneAccumulator {
+    uint8_t a;
+    uint8_t flags;
+} LaneAccumulator;
+
+// Flag tested by each condition code pair NZ/Z, NC/C, PO/PE, P/M
+static const uint8_t ConditionFlag[4] = {FlagZ, FlagCY, FlagP, FlagS};
+
+// Once a group has formed it keeps running on its own for up to this many steps before the
+// lanes outside it get a chance to catch up and join
+static const int GroupRunLength = 64;
+
+#if LOCKSTEP_AVX2
+static bool CpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osSavesAvx = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+LockstepCore::LockstepCore(int laneCount, const uint8_t *rom) : laneCount(laneCount), memory(rom)
+{
+    // whole blocks, so the vector loops never need a tail
+    int padded = (laneCount + BlockLanes - 1) / BlockLanes * BlockLanes;
+    for (int index = 0; index < 8; index++)
+    {
+        if (index != 6)
+        {
+            reg[index].assign(padded, 0);
+        }
+    }
+    flags.assign(padded, FlagOne);
+    sp.assign(padded, 0);
+    pc.assign(padded, 0);
+    halted.assign(padded, 0);
+    intEnable.assign(padded, 0);
+    cycles.assign(padded, 0);
+    targets.assign(padded, 0);
+    left.assign(padded, 0);
+    active.assign(padded, 0);
+    laneStates.resize(laneCount);
+    cpus.reset(new CPU[laneCount]);
+    laneMaps.resize(laneCount);
+    std::vector<bool> mirrored;
+    memoryBase = memory.MapMachines(laneCount, mirrored);
+    for (int lane = 0; lane < laneCount; lane++)
+    {
+        memset(&laneStates[lane], 0, sizeof(CPU::State8080));
+        laneStates[lane].mem = LaneMemory(lane);
+        if (!mirrored[lane])
+        {
+            laneMaps[lane].reset(new MemoryMap(laneStates[lane].mem));
+            laneMaps[lane]->MirrorInvadersRam();
+            cpus[lane].SetMemoryMap(laneMaps[lane].get());
+        }
+    }
+    SetVectorized(true);
+}
+
+LockstepCore::~LockstepCore() {}
+
+int LockstepCore::LaneCount() const
+{
+    return laneCount;
+}
+
+CPU::State8080 *LockstepCore::LaneState(int lane)
+{
+    StoreLane(lane);
+    return &laneStates[lane];
+}
+
+uint64_t LockstepCore::LaneInstructions() const
+{
+    return laneInstructions;
+}
+
+uint64_t LockstepCore::GroupSteps() const
+{
+    return groupSteps;
+}
+
+bool LockstepCore::Vectorized() const
+{
+    return vectorized;
+}
+
+void LockstepCore::SetVectorized(bool enabled)
+{
+#if LOCKSTEP_AVX2
+    vectorized = enabled && CpuHasAvx2();
+#else
+    vectorized = false;
+#endif
+}
+
+// Copies the lane's registers out to its State8080
+void LockstepCore::StoreLane(int lane)
+{
+    CPU::State8080 *state = &laneStates[lane];
+    state->b = reg[0][lane];
+    state->c = reg[1][lane];
+    state->d = reg[2][lane];
+    state->e = reg[3][lane];
+    state->h = reg[4][lane];
+    state->l = reg[5][lane];
+    state->a = reg[7][lane];
+    state->flags = flags[lane];
+    state->sp = sp[lane];
+    state->pc = pc[lane];
+    state->cycles = cycles[lane];
+    state->halted = halted[lane];
+    state->int_enable = intEnable[lane];
+}
+
+void LockstepCore::LoadLane(int lane)
+{
+    CPU::State8080 *state = &laneStates[lane];
+    reg[0][lane] = state->b;
+    reg[1][lane] = state->c;
+    reg[2][lane] = state->d;
+    reg[3][lane] = state->e;
+    reg[4][lane] = state->h;
+    reg[5][lane] = state->l;
+    reg[7][lane] = state->a;
+    flags[lane] = state->flags;
+    sp[lane] = state->sp;
+    pc[lane] = state->pc;
+    cycles[lane] = state->cycles;
+    halted[lane] = state->halted;
+    intEnable[lane] = state->int_enable;
+}
+
+// Runs one instruction for the lane through the reference switch core. Only called inside
+// RunUntil, so cycles is brought up to date from left first
+void LockstepCore::Fallback(int lane)
+{
+    cycles[lane] = targets[lane] - left[lane];
+    StoreLane(lane);
+    int instructionCycles = cpus[lane].Emulate8080Codes(&laneStates[lane]);
+    LoadLane(lane);
+    left[lane] -= instructionCycles;
+}
+
+// Same as CPU::GenerateInterrupt: pushes pc - 1 so the RET that ends the handler lands back on pc
+void LockstepCore::Interrupt(int lane, int interruptNum)
+{
+    if (!intEnable[lane])
+    {
+        return;
+    }
+    halted[lane] = 0;
+    uint16_t valuePC = pc[lane] - 1;
+    Mem(lane, uint16_t(sp[lane] - 2)) = uint8_t(valuePC);
+    Mem(lane, uint16_t(sp[lane] - 1)) = uint8_t(valuePC >> 8);
+    sp[lane] = uint16_t(sp[lane] - 2);
+    pc[lane] = 8 * interruptNum;
+    intEnable[lane] = 0;
+    cycles[lane] += CPU::OpcodeCycles[0xC7];
+}
+
+void LockstepCore::RunFrame()
+{
+    std::vector<uint64_t> frameStart(LaneCount());
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        frameStart[lane] = cycles[lane] - (cycles[lane] % CPU::CyclesPerFrame);
+        targets[lane] = frameStart[lane] + CPU::HalfFrameCycles;
+    }
+    RunUntil();
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        Interrupt(lane, 1);
+        targets[lane] = frameStart[lane] + CPU::CyclesPerFrame;
+    }
+    RunUntil();
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        Interrupt(lane, 2);
+    }
+}
+
+// Picks the running lane furthest behind and marks every lane at the same pc with the same
+// opcode there active. Halted lanes skip to their target like in CPU::RunUntil.
+// Returns false once every lane has reached its target
+bool LockstepCore::FormGroup()
+{
+    int leader = -1;
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        if (left[lane] <= 0)
+        {
+            continue;
+        }
+        if (halted[lane])
+        {
+            left[lane] = 0;
+            continue;
+        }
+        if (leader < 0 || targets[lane] - left[lane] < targets[leader] - left[leader])
+        {
+            leader = lane;
+        }
+    }
+    std::fill(active.begin(), active.end(), 0);
+    groupSize = 0;
+    if (leader < 0)
+    {
+        return false;
+    }
+    uint16_t address = uint16_t(pc[leader]);
+    uint8_t opcode = Mem(leader, address);
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        if (left[lane] > 0 && !halted[lane] && pc[lane] == address && Mem(lane, address) == opcode)
+        {
+            active[lane] = ~0u;
+            groupFirst = groupSize == 0 ? lane : groupFirst;
+            groupEnd = lane + 1;
+            groupSize++;
+        }
+    }
+    return true;
+}
+
+// The first lane in the group that is still running, or -1
+int LockstepCore::GroupLeader()
+{
+    for (int lane = groupFirst; lane < groupEnd; lane++)
+    {
+        if (active[lane] && left[lane] > 0 && !halted[lane])
+        {
+            return lane;
+        }
+    }
+    return -1;
+}
+
+// Lanes that finished, halted or went a different way than the leader drop out of the group
+void LockstepCore::Regroup()
+{
+    int leader = GroupLeader();
+    uint16_t leaderPC = leader < 0 ? 0 : uint16_t(pc[leader]);
+    int leaderOpcode = leader < 0 ? -1 : Mem(leader, leaderPC);
+    int end = 0;
+    int count = 0;
+    for (int lane = groupFirst; lane < groupEnd; lane++)
+    {
+        bool keep = active[lane] && left[lane] > 0 && !halted[lane] && pc[lane] == leaderPC && Mem(lane, leaderPC) == leaderOpcode;
+        active[lane] = keep ? ~0u : 0;
+        if (keep)
+        {
+            end = lane + 1;
+            count++;
+        }
+    }
+    groupFirst = leader < 0 ? 0 : leader;
+    groupEnd = end;
+    groupSize = count;
+}
+
+// Runs every lane up to its target. Inside, a lane counts down the cycles left to its target
+// so the vector loops can work on 32 bit lanes
+void LockstepCore::RunUntil()
+{
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        left[lane] = int32_t(int64_t(targets[lane] - cycles[lane]));
+    }
+    while (FormGroup())
+    {
+        for (int step = 0; step < GroupRunLength && groupSize > 0; step++)
+        {
+            Execute(Mem(groupFirst, uint16_t(pc[groupFirst])));
+#if LOCKSTEP_AVX2
+            if (vectorized)
+            {
+                RegroupAvx2();
+                continue;
+            }
+#endif
+            Regroup();
+        }
+    }
+    for (int lane = 0; lane < LaneCount(); lane++)
+    {
+        cycles[lane] = targets[lane] - left[lane];
+    }
+}
+
+// Runs opcode on every lane in the group. All of them share the opcode but read their own operands
+void LockstepCore::Execute(uint8_t opcode)
+{
+    groupSteps++;
+    laneInstructions += groupSize;
+
+    // IN and OUT need the port hardware in CPU
+    if (opcode == 0xD3 || opcode == 0xDB)
+    {
+        for (int lane = groupFirst; lane < groupEnd; lane++)
+        {
+            if (active[lane])
+            {
+                Fallback(lane);
+            }
+        }
+        return;
+    }
+#if LOCKSTEP_AVX2
+    if (vectorized && ExecuteAvx2(opcode))
+    {
+        return;
+    }
+#endif
+    ExecuteScalar(opcode);
+}
+
+// Execute as a loop over the lanes, one at a time
+// Runs opcode on every lane in group. All of them share the opcode but read their own operands
+void LockstepCore::ExecuteScalar(uint8_t opcode)
+{
+    uint32_t *r[8];
+    for (int index = 0; index < 8; index++)
+    {
+        r[index] = index == 6 ? nullptr : reg[index].data();
+    }
+    uint32_t *a = r[7];
+    uint32_t *f = flags.data();
+    uint32_t *spv = sp.data();
+    uint32_t *pcv = pc.data();
+    int32_t *lft = left.data();
+
+    auto forLanes = [&](auto body)
+    {
+        for (int lane = groupFirst; lane < groupEnd; lane++)
+        {
+            if (active[lane])
+            {
+                body(lane);
+            }
+        }
+    };
+    auto M = [&](int lane, uint16_t address) -> uint8_t &
+    {
+        return Mem(lane, address);
+    };
+    auto HL = [&](int lane)
+    {
+        return uint16_t((r[4][lane] << 8) | r[5][lane]);
+    };
+    auto Imm8 = [&](int lane)
+    {
+        return M(lane, uint16_t(pcv[lane] + 1));
+    };
+    auto Imm16 = [&](int lane)
+    {
+        return uint16_t(M(lane, uint16_t(pcv[lane] + 1)) | (M(lane, uint16_t(pcv[lane] + 2)) << 8));
+    };
+    auto GetPair = [&](int pair, int lane)
+    {
+        return uint16_t(pair == 3 ? spv[lane] : (r[pair * 2][lane] << 8) | r[pair * 2 + 1][lane]);
+    };
+    auto SetPair = [&](int pair, int lane, uint16_t value)
+    {
+        if (pair == 3)
+        {
+            spv[lane] = value;
+        }
+        else
+        {
+            r[pair * 2][lane] = value >> 8;
+            r[pair * 2 + 1][lane] = uint8_t(value);
+        }
+    };
+    // CALL pushes the address of its own last byte and RET adds one back, like the switch core
+    auto Push = [&](int lane, uint16_t value)
+    {
+        M(lane, uint16_t(spv[lane] - 1)) = value >> 8;
+        M(lane, uint16_t(spv[lane] - 2)) = uint8_t(value);
+        spv[lane] = uint16_t(spv[lane] - 2);
+    };
+    auto Pop = [&](int lane)
+    {
+        uint16_t value = M(lane, uint16_t(spv[lane])) | (M(lane, uint16_t(spv[lane] + 1)) << 8);
+        spv[lane] = uint16_t(spv[lane] + 2);
+        return value;
+    };
+    auto Taken = [&](int condition, int lane)
+    {
+        return ((f[lane] & ConditionFlag[condition >> 1]) != 0) == bool(condition & 1);
+    };
+    auto Accumulate = [&](auto operation, auto operandOf)
+    {
+        forLanes([&](int lane)
+        {
+            LaneAccumulator acc = {uint8_t(a[lane]), uint8_t(f[lane])};
+            operation(&acc, operandOf(lane));
+            a[lane] = acc.a;
+            f[lane] = acc.flags;
+        });
+    };
+    // ADD ADC SUB SBB ANA XRA ORA CMP
+    auto Alu = [&](int operation, auto operandOf)
+    {
+        switch (operation)
+        {
+        case 0: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluAdd(acc, value, 0); }, operandOf); break;
+        case 1: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluAdd(acc, value, acc->flags & FlagCY); }, operandOf); break;
+        case 2: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluSubtract(acc, value, 0); }, operandOf); break;
+        case 3: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluSubtract(acc, value, acc->flags & FlagCY); }, operandOf); break;
+        case 4: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluAnd(acc, value); }, operandOf); break;
+        case 5: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluXor(acc, value); }, operandOf); break;
+        case 6: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluOr(acc, value); }, operandOf); break;
+        case 7: Accumulate([](LaneAccumulator *acc, uint8_t value) { AluCompare(acc, value); }, operandOf); break;
+        }
+    };
+
+    int dst = (opcode >> 3) & 7;
+    int src = opcode & 7;
+    int pair = (opcode >> 4) & 3;
+    int length = 1; // 0 when the instruction sets pc itself
+
+    if (opcode == 0x76)
+    {
+        // HLT, pc moves past it so the interrupt returns to the next instruction
+        forLanes([&](int lane) { halted[lane] = 1; });
+    }
+    else if (opcode >= 0x40 && opcode < 0x80)
+    {
+        // MOV
+        uint32_t *to = r[dst];
+        uint32_t *from = r[src];
+        if (dst == 6)
+            forLanes([&](int lane) { M(lane, HL(lane)) = uint8_t(from[lane]); });
+        else if (src == 6)
+            forLanes([&](int lane) { to[lane] = M(lane, HL(lane)); });
+        else
+            forLanes([&](int lane) { to[lane] = from[lane]; });
+    }
+    else if (opcode >= 0x80 && opcode < 0xC0)
+    {
+        uint32_t *from = r[src];
+        if (src == 6)
+            Alu(dst, [&](int lane) { return M(lane, HL(lane)); });
+        else
+            Alu(dst, [&](int lane) { return from[lane]; });
+    }
+    else if (opcode < 0x40)
+    {
+        uint32_t *to = r[dst];
+        switch (opcode & 0x07)
+        {
+        case 0x00: // NOP
+            break;
+        case 0x01:
+            if (opcode & 0x08)
+            {
+                // DAD
+                forLanes([&](int lane)
+                {
+                    uint32_t result = HL(lane) + GetPair(pair, lane);
+                    SetPair(2, lane, uint16_t(result));
+                    f[lane] = (f[lane] & ~FlagCY) | (result >> 16);
+                });
+            }
+            else
+            {
+                // LXI
+                forLanes([&](int lane) { SetPair(pair, lane, Imm16(lane)); });
+                length = 3;
+            }
+            break;
+        case 0x02:
+            switch (opcode)
+            {
+            case 0x02: // STAX
+            case 0x12:
+                forLanes([&](int lane) { M(lane, GetPair(pair, lane)) = uint8_t(a[lane]); });
+                break;
+            case 0x0A: // LDAX
+            case 0x1A:
+                forLanes([&](int lane) { a[lane] = M(lane, GetPair(pair, lane)); });
+                break;
+            case 0x22: // SHLD
+                forLanes([&](int lane)
+                {
+                    uint16_t address = Imm16(lane);
+                    M(lane, address) = uint8_t(r[5][lane]);
+                    M(lane, uint16_t(address + 1)) = uint8_t(r[4][lane]);
+                });
+                length = 3;
+                break;
+            case 0x2A: // LHLD
+                forLanes([&](int lane)
+                {
+                    uint16_t address = Imm16(lane);
+                    r[5][lane] = M(lane, address);
+                    r[4][lane] = M(lane, uint16_t(address + 1));
+                });
+                length = 3;
+                break;
+            case 0x32: // STA
+                forLanes([&](int lane) { M(lane, Imm16(lane)) = uint8_t(a[lane]); });
+                length = 3;
+                break;
+            case 0x3A: // LDA
+                forLanes([&](int lane) { a[lane] = M(lane, Imm16(lane)); });
+                length = 3;
+                break;
+            }
+            break;
+        case 0x03: // INX, DCX
+        {
+            uint16_t change = (opcode & 0x08) ? 0xFFFF : 1;
+            forLanes([&](int lane) { SetPair(pair, lane, GetPair(pair, lane) + change); });
+            break;
+        }
+        case 0x04: // INR
+        case 0x05: // DCR
+        {
+            bool increment = (opcode & 0x07) == 0x04;
+            forLanes([&](int lane)
+            {
+                LaneAccumulator acc = {uint8_t(a[lane]), uint8_t(f[lane])};
+                uint8_t value = dst == 6 ? M(lane, HL(lane)) : uint8_t(to[lane]);
+                value = increment ? AluIncrement(&acc, value) : AluDecrement(&acc, value);
+                if (dst == 6)
+                    M(lane, HL(lane)) = value;
+                else
+                    to[lane] = value;
+                f[lane] = acc.flags;
+            });
+            break;
+        }
+        case 0x06: // MVI
+            if (dst == 6)
+                forLanes([&](int lane) { M(lane, HL(lane)) = Imm8(lane); });
+            else
+                forLanes([&](int lane) { to[lane] = Imm8(lane); });
+            length = 2;
+            break;
+        case 0x07:
+            switch (opcode)
+            {
+            case 0x07: // RLC
+                forLanes([&](int lane) { uint8_t bit = a[lane] >> 7; a[lane] = uint8_t(a[lane] << 1) | bit; f[lane] = (f[lane] & ~FlagCY) | bit; });
+                break;
+            case 0x0F: // RRC
+                forLanes([&](int lane) { uint8_t bit = a[lane] & 1; a[lane] = (a[lane] >> 1) | uint8_t(bit << 7); f[lane] = (f[lane] & ~FlagCY) | bit; });
+                break;
+            case 0x17: // RAL
+                forLanes([&](int lane) { uint8_t bit = a[lane] >> 7; a[lane] = uint8_t(a[lane] << 1) | (f[lane] & FlagCY); f[lane] = (f[lane] & ~FlagCY) | bit; });
+                break;
+            case 0x1F: // RAR
+                forLanes([&](int lane) { uint8_t bit = a[lane] & 1; a[lane] = (a[lane] >> 1) | uint8_t((f[lane] & FlagCY) << 7); f[lane] = (f[lane] & ~FlagCY) | bit; });
+                break;
+            case 0x27: // DAA
+                forLanes([&](int lane)
+                {
+                    LaneAccumulator acc = {uint8_t(a[lane]), uint8_t(f[lane])};
+                    AluDecimalAdjust(&acc);
+                    a[lane] = acc.a;
+                    f[lane] = acc.flags;
+                });
+                break;
+            case 0x2F: // CMA
+                forLanes([&](int lane) { a[lane] ^= 0xFF; });
+                break;
+            case 0x37: // STC
+                forLanes([&](int lane) { f[lane] |= FlagCY; });
+                break;
+            case 0x3F: // CMC
+                forLanes([&](int lane) { f[lane] ^= FlagCY; });
+                break;
+            }
+            break;
+        }
+    }
+    else
+    {
+        switch (opcode & 0x07)
+        {
+        case 0x00: // Rcc
+            forLanes([&](int lane)
+            {
+                if (Taken(dst, lane))
+                {
+                    pcv[lane] = uint16_t(Pop(lane) + 1);
+                    lft[lane] -= 6;
+                }
+                else
+                {
+                    pcv[lane] = uint16_t(pcv[lane] + 1);
+                }
+            });
+            length = 0;
+            break;
+        case 0x01:
+            if (opcode == 0xC9 || opcode == 0xD9)
+            {
+                forLanes([&](int lane) { pcv[lane] = uint16_t(Pop(lane) + 1); });
+                length = 0;
+            }
+            else if (opcode == 0xE9)
+            {
+                forLanes([&](int lane) { pcv[lane] = HL(lane); });
+                length = 0;
+            }
+            else if (opcode == 0xF9)
+            {
+                forLanes([&](int lane) { spv[lane] = HL(lane); });
+            }
+            else if (opcode == 0xF1)
+            {
+                forLanes([&](int lane)
+                {
+                    uint16_t value = Pop(lane);
+                    f[lane] = (value & (FlagS | FlagZ | FlagAC | FlagP | FlagCY)) | FlagOne;
+                    a[lane] = value >> 8;
+                });
+            }
+            else
+            {
+                forLanes([&](int lane) { SetPair(pair, lane, Pop(lane)); });
+            }
+            break;
+        case 0x02: // Jcc
+            forLanes([&](int lane) { pcv[lane] = Taken(dst, lane) ? Imm16(lane) : uint16_t(pcv[lane] + 3); });
+            length = 0;
+            break;
+        case 0x03:
+            switch (opcode)
+            {
+            case 0xC3: // JMP
+            case 0xCB:
+                forLanes([&](int lane) { pcv[lane] = Imm16(lane); });
+                length = 0;
+                break;
+            case 0xE3: // XTHL
+                forLanes([&](int lane)
+                {
+                    uint16_t swapped = HL(lane) - 1;
+                    r[5][lane] = M(lane, uint16_t(spv[lane]));
+                    r[4][lane] = M(lane, uint16_t(spv[lane] + 1));
+                    M(lane, uint16_t(spv[lane])) = uint8_t(swapped);
+                    M(lane, uint16_t(spv[lane] + 1)) = swapped >> 8;
+                });
+                break;
+            case 0xEB: // XCHG
+                forLanes([&](int lane)
+                {
+                    uint16_t swap = HL(lane);
+                    SetPair(2, lane, GetPair(1, lane));
+                    SetPair(1, lane, swap);
+                });
+                break;
+            case 0xF3: // DI
+                forLanes([&](int lane) { intEnable[lane] = 0; });
+                break;
+            case 0xFB: // EI
+                forLanes([&](int lane) { intEnable[lane] = 1; });
+                break;
+            }
+            break;
+        case 0x04: // Ccc
+            forLanes([&](int lane)
+            {
+                if (Taken(dst, lane))
+                {
+                    // read before the push, which can land on the operand, as Emulate8080Codes does
+                    uint16_t target = Imm16(lane);
+                    Push(lane, uint16_t(pcv[lane] + 2));
+                    pcv[lane] = target;
+                    lft[lane] -= 6;
+                }
+                else
+                {
+                    pcv[lane] = uint16_t(pcv[lane] + 3);
+                }
+            });
+            length = 0;
+            break;
+        case 0x05:
+            if (opcode & 0x08)
+            {
+                // CALL and its undocumented copies
+                forLanes([&](int lane)
+                {
+                    uint16_t target = Imm16(lane);
+                    Push(lane, uint16_t(pcv[lane] + 2));
+                    pcv[lane] = target;
+                });
+                length = 0;
+            }
+            else if (opcode == 0xF5)
+            {
+                forLanes([&](int lane) { Push(lane, (a[lane] << 8) | (f[lane] & (FlagS | FlagZ | FlagAC | FlagP | FlagCY)) | FlagOne); });
+            }
+            else
+            {
+                forLanes([&](int lane) { Push(lane, GetPair(pair, lane)); });
+            }
+            break;
+        case 0x06: // ALU immediate
+            Alu(dst, Imm8);
+            length = 2;
+            break;
+        case 0x07: // RST pushes its own address
+            forLanes([&](int lane)
+            {
+                Push(lane, uint16_t(pcv[lane]));
+                pcv[lane] = opcode & 0x38;
+            });
+            length = 0;
+            break;
+        }
+    }
+
+    uint8_t opcodeCycles = CPU::OpcodeCycles[opcode];
+    forLanes([&](int lane)
+    {
+        lft[lane] -= opcodeCycles;
+        pcv[lane] = uint16_t(pcv[lane] + length);
+    });
+}
+
+#if LOCKSTEP_AVX2
+
+// Flags8080 widened to 32 bit entries so the vector ALU can gather from it
+typedef struct LaneFlagTables {
+    uint32_t zsp[256];
+    uint32_t carry[512];
+} LaneFlagTables;
+
+static constexpr LaneFlagTables BuildLaneFlagTables()
+{
+    LaneFlagTables tables{};
+    for (int i = 0; i < 512; i++)
+    {
+        if (i < 256)
+        {
+            tables.zsp[i] = Flags8080.zsp[i];
+        }
+        tables.carry[i] = Flags8080.carry[i];
+    }
+    return tables;
+}
+
+alignas(32) static constexpr LaneFlagTables LaneFlags = BuildLaneFlagTables();
+
+// The register arrays ExecuteAvx2 works on, entry 6 of r stays empty
+typedef struct LaneRegisters {
+    uint32_t *r[8];
+    uint32_t *f;
+    uint32_t *sp;
+} LaneRegisters;
+
+AVX2_TARGET static inline __m256i Splat(int value)
+{
+    return _mm256_set1_epi32(value);
+}
+
+// The 8 entries of a lane array starting at lane first
+AVX2_TARGET static inline __m256i LoadLanes(const void *array, int first)
+{
+    return _mm256_loadu_si256((const __m256i *)((const uint32_t *)array + first));
+}
+
+AVX2_TARGET static inline void StoreLanes(void *array, int first, __m256i value, __m256i mask)
+{
+    _mm256_maskstore_epi32((int *)((uint32_t *)array + first), mask, value);
+}
+
+// Offset of each lane's memory from the block's first lane, see MachineMemory::MapMachines
+AVX2_TARGET static inline __m256i LaneOffsets()
+{
+    const int stride = int(MachineMemory::Stride);
+    return _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+}
+
+// MachineMemory::BoardAddress on every lane
+AVX2_TARGET static inline __m256i FoldLanes(__m256i address)
+{
+    __m256i mirror = _mm256_cmpgt_epi32(address, Splat(0x3FFF));
+    __m256i folded = _mm256_or_si256(_mm256_and_si256(address, Splat(0x1FFF)), Splat(0x2000));
+    return _mm256_blendv_epi8(address, folded, mirror);
+}
+
+// The byte at address in each masked lane's memory, 0 in the others. mem is the block's first lane
+AVX2_TARGET static inline __m256i ReadLanes(const uint8_t *mem, __m256i address, __m256i mask)
+{
+    __m256i offsets = _mm256_add_epi32(LaneOffsets(), FoldLanes(address));
+    __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)mem, offsets, mask, 1);
+    return _mm256_and_si256(words, Splat(0xFF));
+}
+
+// Two bytes each read on their own, the second can be folded or wrap around separately
+AVX2_TARGET static inline __m256i Read16Lanes(const uint8_t *mem, __m256i address, __m256i mask)
+{
+    __m256i high = _mm256_and_si256(_mm256_add_epi32(address, Splat(1)), Splat(0xFFFF));
+    return _mm256_or_si256(ReadLanes(mem, address, mask), _mm256_slli_epi32(ReadLanes(mem, high, mask), 8));
+}
+
+// The two bytes after pc. Every lane in a group shares pc, so unless they straddle the fold at
+// 0x4000 or the wrap at 0xFFFF one 32 bit gather picks up both
+AVX2_TARGET static inline __m256i ReadOperandLanes(const uint8_t *mem, uint16_t pc, __m256i mask)
+{
+    uint16_t low = MachineMemory::BoardAddress(uint16_t(pc + 1));
+    uint16_t high = MachineMemory::BoardAddress(uint16_t(pc + 2));
+    if (high != low + 1)
+    {
+        return Read16Lanes(mem, Splat(uint16_t(pc + 1)), mask);
+    }
+    __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *)(mem + low), LaneOffsets(), mask, 1);
+    return _mm256_and_si256(words, Splat(0xFFFF));
+}
+
+// AVX2 has no scatter, so the masked lanes store their bytes one at a time
+AVX2_TARGET static inline void WriteLanes(uint8_t *mem, __m256i address, __m256i value, __m256i mask)
+{
+    alignas(32) uint32_t offsets[8];
+    alignas(32) uint32_t values[8];
+    _mm256_store_si256((__m256i *)offsets, _mm256_add_epi32(LaneOffsets(), FoldLanes(address)));
+    _mm256_store_si256((__m256i *)values, value);
+    int bits = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+    for (int lane = 0; lane < 8; lane++)
+    {
+        if (bits & (1 << lane))
+        {
+            mem[offsets[lane]] = uint8_t(values[lane]);
+        }
+    }
+}
+
+AVX2_TARGET static inline __m256i ZspLanes(__m256i result)
+{
+    return _mm256_i32gather_epi32((const int *)LaneFlags.zsp, result, 4);
+}
+
+AVX2_TARGET static inline __m256i CarryLanes(__m256i result)
+{
+    return _mm256_i32gather_epi32((const int *)LaneFlags.carry, result, 4);
+}
+
+// ADD ADC SUB SBB ANA XRA ORA CMP on every lane's a and f, same results as alu8080.h
+AVX2_TARGET static inline void AluLanes(int operation, __m256i &a, __m256i &f, __m256i value)
+{
+    __m256i carry = (operation == 1 || operation == 3) ? _mm256_and_si256(f, Splat(FlagCY)) : _mm256_setzero_si256();
+    switch (operation)
+    {
+    case 0: // ADD
+    case 1: // ADC
+    {
+        __m256i result = _mm256_add_epi32(_mm256_add_epi32(a, value), carry);
+        __m256i halfCarry = _mm256_and_si256(_mm256_xor_si256(_mm256_xor_si256(a, value), result), Splat(FlagAC));
+        f = _mm256_or_si256(CarryLanes(result), halfCarry);
+        a = _mm256_and_si256(result, Splat(0xFF));
+        break;
+    }
+    case 2: // SUB
+    case 3: // SBB
+    case 7: // CMP
+    {
+        __m256i result = _mm256_and_si256(_mm256_sub_epi32(_mm256_sub_epi32(a, value), carry), Splat(0x1FF));
+        __m256i halfCarry = _mm256_andnot_si256(_mm256_xor_si256(_mm256_xor_si256(a, value), result), Splat(FlagAC));
+        f = _mm256_or_si256(CarryLanes(result), halfCarry);
+        if (operation != 7)
+        {
+            a = _mm256_and_si256(result, Splat(0xFF));
+        }
+        break;
+    }
+    case 4: // ANA
+    {
+        __m256i halfCarry = _mm256_slli_epi32(_mm256_and_si256(_mm256_or_si256(a, value), Splat(0x08)), 1);
+        a = _mm256_and_si256(a, value);
+        f = _mm256_or_si256(ZspLanes(a), halfCarry);
+        break;
+    }
+    case 5: // XRA
+        a = _mm256_xor_si256(a, value);
+        f = ZspLanes(a);
+        break;
+    case 6: // ORA
+        a = _mm256_or_si256(a, value);
+        f = ZspLanes(a);
+        break;
+    }
+}
+
+// All ones in the lanes where the condition code holds
+AVX2_TARGET static inline __m256i TakenLanes(int condition, __m256i f)
+{
+    __m256i flag = Splat(ConditionFlag[condition >> 1]);
+    __m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(f, flag), flag);
+    return (condition & 1) ? set : _mm256_xor_si256(set, Splat(-1));
+}
+
+AVX2_TARGET static inline __m256i GetPairLanes(const LaneRegisters &regs, int pair, int first)
+{
+    if (pair == 3)
+    {
+        return LoadLanes(regs.sp, first);
+    }
+    return _mm256_or_si256(_mm256_slli_epi32(LoadLanes(regs.r[pair * 2], first), 8), LoadLanes(regs.r[pair * 2 + 1], first));
+}
+
+AVX2_TARGET static inline void SetPairLanes(const LaneRegisters &regs, int pair, int first, __m256i value, __m256i mask)
+{
+    if (pair == 3)
+    {
+        StoreLanes(regs.sp, first, value, mask);
+        return;
+    }
+    StoreLanes(regs.r[pair * 2], first, _mm256_srli_epi32(value, 8), mask);
+    StoreLanes(regs.r[pair * 2 + 1], first, _mm256_and_si256(value, Splat(0xFF)), mask);
+}
+
+AVX2_TARGET static inline void PushLanes(const LaneRegisters &regs, uint8_t *mem, int first, __m256i value, __m256i mask)
+{
+    __m256i stack = LoadLanes(regs.sp, first);
+    __m256i high = _mm256_and_si256(_mm256_sub_epi32(stack, Splat(1)), Splat(0xFFFF));
+    __m256i low = _mm256_and_si256(_mm256_sub_epi32(stack, Splat(2)), Splat(0xFFFF));
+    WriteLanes(mem, high, _mm256_srli_epi32(value, 8), mask);
+    WriteLanes(mem, low, _mm256_and_si256(value, Splat(0xFF)), mask);
+    StoreLanes(regs.sp, first, low, mask);
+}
+
+AVX2_TARGET static inline __m256i PopLanes(const LaneRegisters &regs, const uint8_t *mem, int first, __m256i mask)
+{
+    __m256i stack = LoadLanes(regs.sp, first);
+    __m256i value = Read16Lanes(mem, stack, mask);
+    StoreLanes(regs.sp, first, _mm256_and_si256(_mm256_add_epi32(stack, Splat(2)), Splat(0xFFFF)), mask);
+    return value;
+}
+
+// Execute 8 lanes at a time. Returns false, having done nothing, for the opcodes left to
+// ExecuteScalar
+AVX2_TARGET bool LockstepCore::ExecuteAvx2(uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case 0x27: // DAA
+    case 0x76: // HLT
+    case 0xE3: // XTHL
+    case 0xE9: // PCHL
+    case 0xF3: // DI
+    case 0xF9: // SPHL
+    case 0xFB: // EI
+        return false;
+    }
+    if ((opcode & 0xC7) == 0xC7)
+    {
+        return false; // RST
+    }
+
+    LaneRegisters regs;
+    for (int index = 0; index < 8; index++)
+    {
+        regs.r[index] = index == 6 ? nullptr : reg[index].data();
+    }
+    regs.f = flags.data();
+    regs.sp = sp.data();
+
+    int dst = (opcode >> 3) & 7;
+    int src = opcode & 7;
+    int pair = (opcode >> 4) & 3;
+
+    // every lane in the group sits at the same pc, only what they read differs
+    uint16_t address = uint16_t(pc[groupFirst]);
+    const __m256i next = Splat(uint16_t(address + CPU::OpcodeLengths[opcode]));
+    const __m256i opcodeCycles = Splat(CPU::OpcodeCycles[opcode]);
+    const __m256i takenCycles = Splat(6); // extra for a conditional CALL or RET that goes
+
+    for (int first = groupFirst / BlockLanes * BlockLanes; first < groupEnd; first += BlockLanes)
+    {
+        __m256i mask = LoadLanes(active.data(), first);
+        if (_mm256_testz_si256(mask, mask))
+        {
+            continue;
+        }
+        uint8_t *mem = LaneMemory(first);
+        __m256i newPC = next;
+        __m256i spent = opcodeCycles;
+        __m256i a = LoadLanes(regs.r[7], first);
+        __m256i f = LoadLanes(regs.f, first);
+        __m256i hl = GetPairLanes(regs, 2, first);
+
+        if (opcode >= 0x40 && opcode < 0x80)
+        {
+            // MOV
+            if (dst == 6)
+                WriteLanes(mem, hl, LoadLanes(regs.r[src], first), mask);
+            else
+                StoreLanes(regs.r[dst], first, src == 6 ? ReadLanes(mem, hl, mask) : LoadLanes(regs.r[src], first), mask);
+        }
+        else if (opcode >= 0x80 && opcode < 0xC0)
+        {
+            AluLanes(dst, a, f, src == 6 ? ReadLanes(mem, hl, mask) : LoadLanes(regs.r[src], first));
+            StoreLanes(regs.r[7], first, a, mask);
+            StoreLanes(regs.f, first, f, mask);
+        }
+        else if (opcode < 0x40)
+        {
+            switch (opcode & 0x07)
+            {
+            case 0x00: // NOP
+                break;
+            case 0x01:
+                if (opcode & 0x08)
+                {
+                    // DAD
+                    __m256i result = _mm256_add_epi32(hl, GetPairLanes(regs, pair, first));
+                    SetPairLanes(regs, 2, first, _mm256_and_si256(result, Splat(0xFFFF)), mask);
+                    f = _mm256_or_si256(_mm256_andnot_si256(Splat(FlagCY), f), _mm256_srli_epi32(result, 16));
+                    StoreLanes(regs.f, first, f, mask);
+                }
+                else
+                {
+                    // LXI
+                    SetPairLanes(regs, pair, first, ReadOperandLanes(mem, address, mask), mask);
+                }
+                break;
+            case 0x02:
+                switch (opcode)
+                {
+                case 0x02: // STAX
+                case 0x12:
+                    WriteLanes(mem, GetPairLanes(regs, pair, first), a, mask);
+                    break;
+                case 0x0A: // LDAX
+                case 0x1A:
+                    StoreLanes(regs.r[7], first, ReadLanes(mem, GetPairLanes(regs, pair, first), mask), mask);
+                    break;
+                case 0x22: // SHLD
+                {
+                    __m256i to = ReadOperandLanes(mem, address, mask);
+                    WriteLanes(mem, to, LoadLanes(regs.r[5], first), mask);
+                    WriteLanes(mem, _mm256_and_si256(_mm256_add_epi32(to, Splat(1)), Splat(0xFFFF)), LoadLanes(regs.r[4], first), mask);
+                    break;
+                }
+                case 0x2A: // LHLD
+                    SetPairLanes(regs, 2, first, Read16Lanes(mem, ReadOperandLanes(mem, address, mask), mask), mask);
+                    break;
+                case 0x32: // STA
+                    WriteLanes(mem, ReadOperandLanes(mem, address, mask), a, mask);
+                    break;
+                case 0x3A: // LDA
+                    StoreLanes(regs.r[7], first, ReadLanes(mem, ReadOperandLanes(mem, address, mask), mask), mask);
+                    break;
+                }
+                break;
+            case 0x03: // INX, DCX
+            {
+                __m256i change = Splat((opcode & 0x08) ? 0xFFFF : 1);
+                __m256i value = _mm256_add_epi32(GetPairLanes(regs, pair, first), change);
+                SetPairLanes(regs, pair, first, _mm256_and_si256(value, Splat(0xFFFF)), mask);
+                break;
+            }
+            case 0x04: // INR
+            case 0x05: // DCR
+            {
+                __m256i value = dst == 6 ? ReadLanes(mem, hl, mask) : LoadLanes(regs.r[dst], first);
+                __m256i halfCarry;
+                if ((opcode & 0x07) == 0x04)
+                {
+                    value = _mm256_and_si256(_mm256_add_epi32(value, Splat(1)), Splat(0xFF));
+                    halfCarry = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(value, Splat(0x0F)), _mm256_setzero_si256()), Splat(FlagAC));
+                }
+                else
+                {
+                    value = _mm256_and_si256(_mm256_sub_epi32(value, Splat(1)), Splat(0xFF));
+                    halfCarry = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(value, Splat(0x0F)), Splat(0x0F)), Splat(FlagAC));
+                }
+                f = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(f, Splat(FlagCY)), ZspLanes(value)), halfCarry);
+                if (dst == 6)
+                    WriteLanes(mem, hl, value, mask);
+                else
+                    StoreLanes(regs.r[dst], first, value, mask);
+                StoreLanes(regs.f, first, f, mask);
+                break;
+            }
+            case 0x06: // MVI
+            {
+                __m256i value = _mm256_and_si256(ReadOperandLanes(mem, address, mask), Splat(0xFF));
+                if (dst == 6)
+                    WriteLanes(mem, hl, value, mask);
+                else
+                    StoreLanes(regs.r[dst], first, value, mask);
+                break;
+            }
+            case 0x07:
+            {
+                __m256i carry = _mm256_and_si256(f, Splat(FlagCY));
+                __m256i bit = _mm256_setzero_si256();
+                switch (opcode)
+                {
+                case 0x07: // RLC
+                    bit = _mm256_srli_epi32(a, 7);
+                    a = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(a, 1), Splat(0xFF)), bit);
+                    break;
+                case 0x0F: // RRC
+                    bit = _mm256_and_si256(a, Splat(1));
+                    a = _mm256_or_si256(_mm256_srli_epi32(a, 1), _mm256_slli_epi32(bit, 7));
+                    break;
+                case 0x17: // RAL
+                    bit = _mm256_srli_epi32(a, 7);
+                    a = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(a, 1), Splat(0xFF)), carry);
+                    break;
+                case 0x1F: // RAR
+                    bit = _mm256_and_si256(a, Splat(1));
+                    a = _mm256_or_si256(_mm256_srli_epi32(a, 1), _mm256_slli_epi32(carry, 7));
+                    break;
+                case 0x2F: // CMA
+                    a = _mm256_xor_si256(a, Splat(0xFF));
+                    bit = carry;
+                    break;
+                case 0x37: // STC
+                    bit = Splat(FlagCY);
+                    break;
+                case 0x3F: // CMC
+                    bit = _mm256_xor_si256(carry, Splat(FlagCY));
+                    break;
+                }
+                StoreLanes(regs.r[7], first, a, mask);
+                StoreLanes(regs.f, first, _mm256_or_si256(_mm256_andnot_si256(Splat(FlagCY), f), bit), mask);
+                break;
+            }
+            }
+        }
+        else
+        {
+            switch (opcode & 0x07)
+            {
+            case 0x00: // Rcc
+            {
+                __m256i taken = _mm256_and_si256(TakenLanes(dst, f), mask);
+                __m256i back = _mm256_and_si256(_mm256_add_epi32(PopLanes(regs, mem, first, taken), Splat(1)), Splat(0xFFFF));
+                newPC = _mm256_blendv_epi8(Splat(uint16_t(address + 1)), back, taken);
+                spent = _mm256_add_epi32(spent, _mm256_and_si256(takenCycles, taken));
+                break;
+            }
+            case 0x01:
+                if (opcode == 0xC9 || opcode == 0xD9)
+                {
+                    // RET
+                    newPC = _mm256_and_si256(_mm256_add_epi32(PopLanes(regs, mem, first, mask), Splat(1)), Splat(0xFFFF));
+                }
+                else if (opcode == 0xF1)
+                {
+                    // POP PSW
+                    __m256i value = PopLanes(regs, mem, first, mask);
+                    StoreLanes(regs.f, first, _mm256_or_si256(_mm256_and_si256(value, Splat(FlagS | FlagZ | FlagAC | FlagP | FlagCY)), Splat(FlagOne)), mask);
+                    StoreLanes(regs.r[7], first, _mm256_srli_epi32(value, 8), mask);
+                }
+                else
+                {
+                    SetPairLanes(regs, pair, first, PopLanes(regs, mem, first, mask), mask);
+                }
+                break;
+            case 0x02: // Jcc
+            {
+                __m256i taken = TakenLanes(dst, f);
+                newPC = _mm256_blendv_epi8(Splat(uint16_t(address + 3)), ReadOperandLanes(mem, address, mask), taken);
+                break;
+            }
+            case 0x03:
+                if (opcode == 0xEB)
+                {
+                    // XCHG
+                    __m256i de = GetPairLanes(regs, 1, first);
+                    SetPairLanes(regs, 1, first, hl, mask);
+                    SetPairLanes(regs, 2, first, de, mask);
+                }
+                else
+                {
+                    // JMP and its undocumented copy
+                    newPC = ReadOperandLanes(mem, address, mask);
+                }
+                break;
+            case 0x04: // Ccc
+            {
+                // read before the push, which can land on the operand, as Emulate8080Codes does
+                __m256i taken = _mm256_and_si256(TakenLanes(dst, f), mask);
+                __m256i target = ReadOperandLanes(mem, address, taken);
+                PushLanes(regs, mem, first, Splat(uint16_t(address + 2)), taken);
+                newPC = _mm256_blendv_epi8(Splat(uint16_t(address + 3)), target, taken);
+                spent = _mm256_add_epi32(spent, _mm256_and_si256(takenCycles, taken));
+                break;
+            }
+            case 0x05:
+                if (opcode & 0x08)
+                {
+                    // CALL and its undocumented copies
+                    __m256i target = ReadOperandLanes(mem, address, mask);
+                    PushLanes(regs, mem, first, Splat(uint16_t(address + 2)), mask);
+                    newPC = target;
+                }
+                else if (opcode == 0xF5)
+                {
+                    __m256i psw = _mm256_and_si256(f, Splat(FlagS | FlagZ | FlagAC | FlagP | FlagCY));
+                    PushLanes(regs, mem, first, _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a, 8), psw), Splat(FlagOne)), mask);
+                }
+                else
+                {
+                    PushLanes(regs, mem, first, GetPairLanes(regs, pair, first), mask);
+                }
+                break;
+            case 0x06: // ALU immediate
+                AluLanes(dst, a, f, _mm256_and_si256(ReadOperandLanes(mem, address, mask), Splat(0xFF)));
+                StoreLanes(regs.r[7], first, a, mask);
+                StoreLanes(regs.f, first, f, mask);
+                break;
+            }
+        }
+
+        StoreLanes(pc.data(), first, newPC, mask);
+        StoreLanes(left.data(), first, _mm256_sub_epi32(LoadLanes(left.data(), first), spent), mask);
+    }
+    return true;
+}
+
+// Regroup 8 lanes at a time
+AVX2_TARGET void LockstepCore::RegroupAvx2()
+{
+    int leader = GroupLeader();
+    uint16_t leaderPC = leader < 0 ? 0 : uint16_t(pc[leader]);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i leaderPCs = Splat(leaderPC);
+    const __m256i leaderOpcodes = Splat(leader < 0 ? -1 : Mem(leader, leaderPC));
+    int end = 0;
+    int count = 0;
+    for (int first = groupFirst / BlockLanes * BlockLanes; first < groupEnd; first += BlockLanes)
+    {
+        __m256i mask = LoadLanes(active.data(), first);
+        if (_mm256_testz_si256(mask, mask))
+        {
+            continue;
+        }
+        __m256i keep = _mm256_and_si256(mask, _mm256_cmpgt_epi32(LoadLanes(left.data(), first), zero));
+        keep = _mm256_and_si256(keep, _mm256_cmpeq_epi32(LoadLanes(halted.data(), first), zero));
+        keep = _mm256_and_si256(keep, _mm256_cmpeq_epi32(LoadLanes(pc.data(), first), leaderPCs));
+        keep = _mm256_and_si256(keep, _mm256_cmpeq_epi32(ReadLanes(LaneMemory(first), leaderPCs, keep), leaderOpcodes));
+        _mm256_storeu_si256((__m256i *)(active.data() + first), keep);
+        int bits = _mm256_movemask_ps(_mm256_castsi256_ps(keep));
+        for (int lane = 0; lane < BlockLanes; lane++)
+        {
+            if (bits & (1 << lane))
+            {
+                end = first + lane + 1;
+                count++;
+            }
+        }
+    }
+    groupFirst = leader < 0 ? 0 : leader;
+    groupEnd = end;
+    groupSize = count;
+}
+
+#endif
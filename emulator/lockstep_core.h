@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "emulator_shell.h"
+#include "machine_memory.h"
+#include "memory_map.h"
+
+// Runs many Space Invaders machines in lockstep, one lane per machine.
+// The registers are kept as a struct of arrays, one array per register with a 32 bit entry per
+// lane, and each step fetches and decodes one opcode for every lane sitting at the same pc, then
+// runs it across those lanes. Lanes running the same ROM stay together almost all the time, so
+// the decode and dispatch are paid once per group instead of once per machine.
+// With AVX2 a group runs 8 lanes to a register: lanes outside the group are masked off, memory
+// reads are gathers, memory writes go out one masked lane at a time since AVX2 has no scatter,
+// and the flags come from gathers into 32 bit copies of the alu8080.h tables. Hosts without AVX2
+// and a few rare opcodes (DAA, HLT, XTHL, PCHL, SPHL, DI, EI, RST) run a scalar loop over the
+// lanes instead. Every lane maps the one shared ROM and has its own 8K of RAM (machine_memory.h),
+// all from one block so lane n's memory sits n strides after lane 0's and one gather reaches 8
+// lanes. Addresses from 0x4000 up are folded onto that RAM here so lanes the host couldn't mirror
+// behave the same. Lanes that branch differently just form separate groups, the lane furthest
+// behind always runs next so they can meet up again. Results match Emulate8080Codes lane for
+// lane; IN and OUT are handed to it since the port hardware lives in CPU
+class LockstepCore {
+
+public:
+    // rom holds the 8K image every lane runs, see LoadInvadersRomImage
+    LockstepCore(int laneCount, const uint8_t *rom);
+    ~LockstepCore();
+
+    int LaneCount() const;
+
+    // The lane as a State8080. mem, the input ports and the output ports are live, the
+    // registers are a copy taken when this is called
+    CPU::State8080 *LaneState(int lane);
+
+    // Takes the registers back from LaneState(lane) after they have been changed there
+    void LoadLane(int lane);
+
+    // One 60 Hz frame on every lane, with the RST 1 and RST 2 interrupts like CPU::RunFrame
+    void RunFrame();
+
+    // Instructions run so far summed over the lanes, and the number of groups it took
+    uint64_t LaneInstructions() const;
+    uint64_t GroupSteps() const;
+
+    // Whether groups run on AVX2. On by default where the CPU has it, turning it off runs the
+    // scalar loop for every opcode
+    bool Vectorized() const;
+    void SetVectorized(bool enabled);
+
+private:
+    static const int BlockLanes = 8; // lanes in one AVX2 register
+
+    int laneCount;
+
+    // One entry per lane, padded out to a whole number of blocks.
+    // Registers in 8080 encoding order B C D E H L (M) A, entry 6 stays empty
+    std::vector<uint32_t> reg[8];
+    std::vector<uint32_t> flags;
+    std::vector<uint32_t> sp;
+    std::vector<uint32_t> pc;
+    std::vector<uint32_t> halted;
+    std::vector<uint32_t> intEnable;
+    std::vector<uint64_t> cycles;  // kept up to date outside RunUntil
+    std::vector<uint64_t> targets; // where RunUntil stops each lane
+    std::vector<int32_t> left;     // cycles to target, in place of cycles inside RunUntil
+    std::vector<uint32_t> active;  // all ones for lanes running the current opcode
+
+    MachineMemory memory;
+    uint8_t *memoryBase; // lane 0's 64K view, lane n's is n strides on
+    std::vector<CPU::State8080> laneStates; // ports and the scalar view handed out by LaneState
+    std::unique_ptr<CPU[]> cpus;            // shift register and port handling per lane
+    std::vector<std::unique_ptr<MemoryMap>> laneMaps; // mirrors for IN and OUT on lanes without them
+
+    // The group is every active lane, all of them in [groupFirst, groupEnd) with the first
+    // one at groupFirst
+    int groupFirst = 0;
+    int groupEnd = 0;
+    int groupSize = 0;
+    bool vectorized = false;
+    uint64_t laneInstructions = 0;
+    uint64_t groupSteps = 0;
+
+    uint8_t *LaneMemory(int lane)
+    {
+        return memoryBase + size_t(lane) * MachineMemory::Stride;
+    }
+
+    uint8_t &Mem(int lane, uint16_t address)
+    {
+        return LaneMemory(lane)[MachineMemory::BoardAddress(address)];
+    }
+
+    void StoreLane(int lane);
+    void RunUntil();
+    bool FormGroup();
+    int GroupLeader();
+    void Regroup();
+    void RegroupAvx2();
+    void Execute(uint8_t opcode);
+    void ExecuteScalar(uint8_t opcode);
+    bool ExecuteAvx2(uint8_t opcode);
+    void Interrupt(int lane, int interruptNum);
+    void Fallback(int lane);
+};
@@ -0,0 +1,207 @@
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "machine_memory.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MACHINE_MEMORY_MAPPED 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef MACHINE_MEMORY_MAPPED
+// An unnamed shared memory file of size bytes, -1 if the host won't make one
+static int CreateSharedFile(off_t size)
+{
+#if defined(__linux__)
+    int file = memfd_create("invaders", 0);
+#else
+    static int fileCount = 0;
+    char name[64];
+    snprintf(name, sizeof(name), "/invaders-%d-%d", int(getpid()), fileCount++);
+    int file = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file >= 0)
+    {
+        shm_unlink(name);
+    }
+#endif
+    if (file >= 0 && ftruncate(file, size) != 0)
+    {
+        close(file);
+        file = -1;
+    }
+    return file;
+}
+
+// Kernel mappings one machine's board layout adds: the ROM, the RAM and its six mirrors, and the
+// split of the block's anonymous mapping around them
+static const long BoardMappings = 9;
+
+// How many more mappings board layouts may take. Half of what vm.max_map_count allows the process,
+// less what it has already, so block caches, jit buffers and thread stacks still find room
+static long MappingBudget()
+{
+#if defined(__linux__)
+    long limit = 65530;
+    FILE *file = fopen("/proc/sys/vm/max_map_count", "r");
+    if (file)
+    {
+        if (fscanf(file, "%ld", &limit) != 1)
+        {
+            limit = 65530;
+        }
+        fclose(file);
+    }
+    long used = 0;
+    file = fopen("/proc/self/maps", "r");
+    if (file)
+    {
+        for (int character = fgetc(file); character != EOF; character = fgetc(file))
+        {
+            used += character == '\n';
+        }
+        fclose(file);
+    }
+    return limit / 2 - used;
+#else
+    return LONG_MAX;
+#endif
+}
+#endif
+
+MachineMemory::MachineMemory(const uint8_t *image) : rom(image, image + RomSize)
+{
+#ifdef MACHINE_MEMORY_MAPPED
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize <= 0 || GuardSize % pageSize != 0 || RamSize % pageSize != 0)
+    {
+        return; // 16K pages can't map 8K of ROM or RAM on their own, stay with flat copies
+    }
+    fd = CreateSharedFile(RomSize);
+    if (fd >= 0 && pwrite(fd, rom.data(), RomSize, 0) != RomSize)
+    {
+        close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+MachineMemory::~MachineMemory()
+{
+    for (const Region &region : regions)
+    {
+#ifdef MACHINE_MEMORY_MAPPED
+        if (region.mapped)
+        {
+            munmap(region.start, region.size); // takes the ROM and RAM mappings with it
+            continue;
+        }
+#endif
+        free(region.start);
+    }
+#ifdef MACHINE_MEMORY_MAPPED
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+#endif
+}
+
+bool MachineMemory::Shared() const
+{
+    return fd >= 0 && !outOfMappings;
+}
+
+// Puts the ROM, a new 8K of RAM and its mirrors over the window at mem. If the host says no
+// part way through, what did get mapped goes back to plain anonymous memory and it returns false
+bool MachineMemory::MapBoard(uint8_t *mem)
+{
+#ifdef MACHINE_MEMORY_MAPPED
+    if (fd < 0 || outOfMappings)
+    {
+        return false;
+    }
+    int ram = CreateSharedFile(RamSize);
+    size_t mapped = 0;
+    bool ok = ram >= 0 && mmap(mem, RomSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED;
+    if (ok)
+    {
+        mapped = RomSize;
+    }
+    for (int address = 0x2000; ok && address < 0x10000; address += RamSize)
+    {
+        ok = mmap(mem + address, RamSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, ram, 0) != MAP_FAILED;
+        if (ok)
+        {
+            mapped += RamSize;
+        }
+    }
+    if (ram >= 0)
+    {
+        close(ram); // the mappings keep the RAM alive
+    }
+    if (!ok)
+    {
+        outOfMappings = true;
+        // Replacing the mappings in one go would need a new one first, which the host just
+        // refused. Their range ends where a mapping does, so unmapping it needs no split and the
+        // anonymous memory put back merges with the window around it
+        if (mapped && (munmap(mem, mapped) != 0 ||
+                       mmap(mem, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED))
+        {
+            printf("error: couldn't undo a partly mapped machine\n");
+            exit(1);
+        }
+    }
+    return ok;
+#else
+    (void)mem;
+    return false;
+#endif
+}
+
+uint8_t *MachineMemory::MapMachines(int count, std::vector<bool> &mirrored)
+{
+    size_t size = size_t(count) * Stride;
+    Region region = {nullptr, size, false};
+#ifdef MACHINE_MEMORY_MAPPED
+    void *block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block != MAP_FAILED)
+    {
+        region.start = (uint8_t *)block;
+        region.mapped = true;
+    }
+#endif
+    if (!region.start)
+    {
+        region.start = (uint8_t *)calloc(1, size);
+        if (!region.start)
+        {
+            printf("error: out of memory for %d machines\n", count);
+            exit(1);
+        }
+    }
+    regions.push_back(region);
+
+    long budget = 0;
+#ifdef MACHINE_MEMORY_MAPPED
+    if (region.mapped && Shared())
+    {
+        budget = MappingBudget();
+    }
+#endif
+    for (int index = 0; index < count; index++)
+    {
+        uint8_t *mem = region.start + size_t(index) * Stride + GuardSize;
+        bool board = budget >= BoardMappings && MapBoard(mem);
+        budget -= BoardMappings;
+        if (!board)
+        {
+            memcpy(mem, rom.data(), RomSize);
+        }
+        mirrored.push_back(board);
+    }
+    return region.start + GuardSize;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Address spaces for many machines that share one copy of the ROM.
+// The Space Invaders board has 8K of ROM at 0x0000 and 8K of RAM at 0x2000, and the RAM shows up
+// again every 8K from 0x4000 to the top of memory. Machines are handed out in one block of
+// anonymous memory, a 64K window each. Over every window go the ROM from one shared memory file
+// (copy on write, so a stray ROM write only costs that machine a private page) and the machine's
+// own 8K RAM file, mapped at 0x2000 and again at each mirror. The host page table does the
+// mirroring, so the cores still index mem as a flat array with no extra work per access.
+// That is nine kernel mappings a machine. They may use half of Linux's vm.max_map_count, the rest
+// is left for block caches, jit buffers and thread stacks, so with the default limit about 3600
+// machines get the host's mirrors. Past that, and where mapping isn't available at all (Windows,
+// 16K pages), a machine gets a plain 64K copy with the ROM in it and no mirrors. MapMachines says
+// which machines those are: a core that indexes their mem directly has to fold 0x4000 up onto
+// the RAM itself, or run them through a MemoryMap set up with MirrorInvadersRam.
+// The block cache doesn't see writes made through a mirror, the ROM never runs code from RAM
+class MachineMemory {
+
+public:
+    // rom holds RomSize bytes, they are copied in once
+    explicit MachineMemory(const uint8_t *rom);
+    ~MachineMemory();
+
+    static const int RomSize = 0x2000;
+    static const int RamSize = 0x2000;
+
+    // A spare page either side of every 64K. The switch core indexes the stack and instruction
+    // operands with plain ints and can reach a couple of bytes past either end
+    static const size_t GuardSize = 0x1000;
+    static const size_t Stride = 0x10000 + 2 * GuardSize; // from one machine to the next
+
+    // count new 64K address spaces with the ROM in place and RAM zeroed, Stride bytes apart
+    // starting at the one returned. mirrored gets an entry per machine, true when the host maps
+    // that machine's 0x4000 up onto its RAM
+    uint8_t *MapMachines(int count, std::vector<bool> &mirrored);
+
+    // Where address lands on the board, with 0x4000 up folded onto the RAM at 0x2000. For cores
+    // that index a machine's mem directly and can't count on the host's mirrors
+    static uint16_t BoardAddress(uint16_t address)
+    {
+        return address < 0x4000 ? address : uint16_t(0x2000 | (address & (RamSize - 1)));
+    }
+
+    // True when machines share the ROM pages and get their mirrors from the host, until the
+    // host runs out of mappings
+    bool Shared() const;
+
+private:
+    typedef struct Region {
+        uint8_t *start;
+        size_t size;
+        bool mapped; // mmap, otherwise calloc
+    } Region;
+
+    std::vector<uint8_t> rom;
+    std::vector<Region> regions;
+    int fd = -1; // shared memory file holding the ROM
+    bool outOfMappings = false; // a board mapping failed once, the rest get flat copies
+
+    bool MapBoard(uint8_t *mem);
+};
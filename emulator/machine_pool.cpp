@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <system_error>
+#include "machine_pool.h"
+#include "rom_loader.h"
+
+MachinePool::MachinePool(int machineCount, int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::max(1, std::min(threadCount, machineCount));
+
+    // The threads come first: with tens of thousands of machines mapped there may be no room
+    // left for their stacks. A pool that can't start them all runs on the ones it got
+    rangeSize = std::max(1, machineCount / (threadCount * 16));
+    for (int worker = 0; worker < threadCount; worker++)
+    {
+        queues.emplace_back(new WorkQueue());
+    }
+    for (int worker = 1; worker < threadCount; worker++)
+    {
+        try
+        {
+            workers.emplace_back(&MachinePool::WorkerLoop, this, worker);
+        }
+        catch (const std::system_error &error)
+        {
+            printf("warning: running on %d threads, couldn't start another (%s)\n", worker, error.what());
+            queues.resize(worker);
+            break;
+        }
+    }
+
+    // the ROM is read from disk once, every machine maps the same copy of it
+    uint8_t rom[MachineMemory::RomSize];
+    LoadInvadersRomImage(rom);
+    memory.reset(new MachineMemory(rom));
+    std::vector<bool> mirrored;
+    uint8_t *mem = memory->MapMachines(machineCount, mirrored);
+    for (int index = 0; index < machineCount; index++)
+    {
+        std::unique_ptr<Machine> machine(new Machine());
+        machine->state = (CPU::State8080 *)calloc(1, sizeof(CPU::State8080));
+        if (!machine->state)
+        {
+            printf("error: out of memory for machine %d\n", index);
+            exit(1);
+        }
+        machine->state->mem = mem + size_t(index) * MachineMemory::Stride;
+        machine->cpu.SetCore(CPU::ThreadedCore);
+        if (!mirrored[index])
+        {
+            // the host ran out of mappings, the page map does the mirroring instead
+            machine->map.reset(new MemoryMap(machine->state->mem));
+            machine->map->MirrorInvadersRam();
+            machine->cpu.SetMemoryMap(machine->map.get());
+        }
+        machines.push_back(std::move(machine));
+    }
+}
+
+MachinePool::~MachinePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(roundLock);
+        stopping = true;
+    }
+    roundStart.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    for (std::unique_ptr<Machine> &machine : machines)
+    {
+        free(machine->state); // mem belongs to the arena
+    }
+}
+
+int MachinePool::MachineCount() const
+{
+    return int(machines.size());
+}
+
+int MachinePool::ThreadCount() const
+{
+    return int(queues.size());
+}
+
+Machine &MachinePool::GetMachine(int index)
+{
+    return *machines[index];
+}
+
+void MachinePool::SetCore(CPU::CoreType core)
+{
+    for (std::unique_ptr<Machine> &machine : machines)
+    {
+        machine->cpu.SetCore(core);
+    }
+}
+
+uint64_t MachinePool::TotalFrames() const
+{
+    uint64_t total = 0;
+    for (const std::unique_ptr<Machine> &machine : machines)
+    {
+        total += machine->frames;
+    }
+    return total;
+}
+
+// The owner works from the back of its queue, thieves take from the front
+bool MachinePool::PopLocal(int worker, WorkRange &range)
+{
+    WorkQueue &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.lock);
+    if (queue.ranges.empty())
+    {
+        return false;
+    }
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+bool MachinePool::Steal(int worker, WorkRange &range)
+{
+    int threadCount = ThreadCount();
+    for (int offset = 1; offset < threadCount; offset++)
+    {
+        WorkQueue &queue = *queues[(worker + offset) % threadCount];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        if (!queue.ranges.empty())
+        {
+            range = queue.ranges.front();
+            queue.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs ranges until every queue is empty. Ranges are only ever added before the round starts,
+// so once nothing is left to pop or steal the thread is done with this frame
+void MachinePool::RunRound(int worker)
+{
+    WorkRange range;
+    while (PopLocal(worker, range) || Steal(worker, range))
+    {
+        for (int index = range.begin; index < range.end; index++)
+        {
+            Machine &machine = *machines[index];
+            machine.cpu.RunFrame(machine.state);
+            machine.frames++;
+        }
+    }
+}
+
+void MachinePool::WorkerLoop(int worker)
+{
+    uint64_t lastRound = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(roundLock);
+            roundStart.wait(lock, [&]() { return stopping || round != lastRound; });
+            if (stopping)
+            {
+                return;
+            }
+            lastRound = round;
+        }
+        RunRound(worker);
+        {
+            std::lock_guard<std::mutex> lock(roundLock);
+            if (--busyWorkers == 0)
+            {
+                roundDone.notify_one();
+            }
+        }
+    }
+}
+
+void MachinePool::StepFrame()
+{
+    // deal the machines out in contiguous ranges, round robin over the threads
+    int threadCount = ThreadCount();
+    int next = 0;
+    for (int begin = 0; begin < MachineCount(); begin += rangeSize)
+    {
+        WorkRange range = {begin, std::min(begin + rangeSize, MachineCount())};
+        WorkQueue &queue = *queues[next];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        queue.ranges.push_back(range);
+        next = (next + 1) % threadCount;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(roundLock);
+        busyWorkers = threadCount - 1;
+        round++;
+    }
+    roundStart.notify_all();
+    RunRound(0);
+
+    std::unique_lock<std::mutex> lock(roundLock);
+    roundDone.wait(lock, [&]() { return busyWorkers == 0; });
+}
+
+void MachinePool::RunFrames(int frames)
+{
+    for (int frame = 0; frame < frames; frame++)
+    {
+        StepFrame();
+    }
+}
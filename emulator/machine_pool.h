@@ -0,0 +1,78 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "emulator_shell.h"
+#include "machine_memory.h"
+#include "memory_map.h"
+
+// One complete Space Invaders board: its own cpu (with the shift register), its own State8080
+// with RAM and input ports. The only thing shared with other machines is the read only ROM
+typedef struct Machine {
+    CPU cpu;
+    CPU::State8080 *state = nullptr;
+    uint64_t frames = 0; // frames this machine has run
+    std::unique_ptr<MemoryMap> map; // RAM mirrors for a machine the host couldn't mirror, see MachineMemory
+} Machine;
+
+// Owns a set of independent machines and steps them frame by frame on a pool of threads.
+// Every frame each thread starts on its own queue of machines and, once that runs dry, steals
+// from the front of the other threads' queues, so a few slow machines don't hold up a whole
+// thread while the rest sit idle. The calling thread works as thread 0, so StepFrame returns
+// only when every machine has run the frame and it is safe to change inputs between frames
+class MachinePool {
+
+public:
+    // threadCount 0 uses one thread per hardware thread
+    MachinePool(int machineCount, int threadCount = 0);
+    ~MachinePool();
+
+    int MachineCount() const;
+    int ThreadCount() const;
+    Machine &GetMachine(int index);
+    void SetCore(CPU::CoreType core);
+
+    // Runs one frame on every machine
+    void StepFrame();
+
+    void RunFrames(int frames);
+
+    // Frames run so far summed over all machines
+    uint64_t TotalFrames() const;
+
+private:
+    // Machines [begin, end) still to run this frame
+    typedef struct WorkRange {
+        int begin;
+        int end;
+    } WorkRange;
+
+    typedef struct WorkQueue {
+        std::mutex lock;
+        std::deque<WorkRange> ranges;
+    } WorkQueue;
+
+    bool PopLocal(int worker, WorkRange &range);
+    bool Steal(int worker, WorkRange &range);
+    void RunRound(int worker);
+    void WorkerLoop(int worker);
+
+    std::unique_ptr<MachineMemory> memory; // address spaces, all sharing one copy of the ROM
+    std::vector<std::unique_ptr<Machine>> machines;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    int rangeSize = 1;
+
+    // Round handshake between StepFrame and the worker threads
+    std::mutex roundLock;
+    std::condition_variable roundStart;
+    std::condition_variable roundDone;
+    uint64_t round = 0;
+    int busyWorkers = 0;
+    bool stopping = false;
+};
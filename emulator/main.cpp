@@ -1,70 +1,90 @@
-#include <fstream>
 #include <chrono>
-#include <filesystem>
+#include <cstring>
 #include <thread>
 #include <atomic>
+#include <SDL.h>
 #include "emulator_shell.h"
+#include "rom_loader.h"
 #include "../inputoutput/inputHandler.h"
+#include "../inputoutput/soundHandler.h"
 #include "../renderer8080/renderer.h"
+#include "../renderer8080/triple_buffer.h"
 
 using namespace std;
 using namespace std::chrono;
-namespace FileSystem = std::filesystem;
 std::atomic<bool> quit{false};
 
+// Video RAM as it was when the beam finished a band of it. Only the band's columns are copied,
+// the rest of vram is whatever this buffer held before
+typedef struct VramFrame {
+    uint8_t vram[Renderer8080::VramColumns * Renderer8080::VramColumnBytes];
+    int firstColumn;
+    int columnCount;
+} VramFrame;
 
-void ReadFileIntoMemoryAt(CPU::State8080 *state, const char *filename, uint32_t offset)
-{
-    FILE *f;
-    std::filesystem::path romPath = filename;
-    string filepath = FileSystem::absolute(romPath).string();
-    const char *rawFilePath = filepath.c_str();
-    const char *mode = "rb";
-#ifdef _WIN32
-    errno_t err = fopen_s(&f, rawFilePath, mode);
-#else
-    f = fopen(rawFilePath, mode);
-#endif
-    if (f == NULL)
-    {
-        printf("error: Couldn't open %s\n", filename);
-        exit(1);
-    }
-    fseek(f, 0L, SEEK_END);
-    int fsize = ftell(f);
-    fseek(f, 0L, SEEK_SET);
+// The cpu thread publishes a copy of video RAM as the emulated beam finishes with it and posts
+// the semaphore, the render thread sleeps on it and draws the newest copy. Posting never blocks
+// and a post made before the render thread waits is still counted, so no frame's wakeup is lost.
+// The render thread never reads state->mem, which the cpu thread is writing
+typedef struct FrameSignal {
+    TripleBuffer<VramFrame> frames;
+    SDL_sem *ready = nullptr; // one post per published frame, and one more to wake it for quit
+    bool beamRacing = false; // publish each half as the beam leaves it instead of all at vblank
+} FrameSignal;
 
-    uint8_t *buffer = &state->mem[offset];
-    fread(buffer, fsize, 1, f);
-    fclose(f);
-}
+FrameSignal frameSignal;
 
-CPU::State8080 *Init8080(void)
+void PublishFrame(CPU::State8080 *state, int interruptNum, void *context)
 {
-    // allocate initialized data for cpu state
-    CPU::State8080 *state = (CPU::State8080 *)calloc(1, sizeof(CPU::State8080));
-    // point state->mem toward 16k of memory
-    state->mem = (uint8_t *)malloc(0x10000); // 16K
-    return state;
+    FrameSignal *signal = (FrameSignal *)context;
+    // each VRAM column is one raster line, RST 1 comes with the beam half way down
+    const int halfColumns = Renderer8080::VramColumns / 2;
+    int firstColumn = 0;
+    int columnCount = Renderer8080::VramColumns;
+    if (signal->beamRacing)
+    {
+        firstColumn = interruptNum == 1 ? 0 : halfColumns;
+        columnCount = halfColumns;
+    }
+    else if (interruptNum != 2)
+    {
+        return;
+    }
+    VramFrame &frame = signal->frames.Back();
+    int offset = firstColumn * Renderer8080::VramColumnBytes;
+    memcpy(frame.vram + offset, &state->mem[Renderer8080::VramStart + offset], columnCount * Renderer8080::VramColumnBytes);
+    frame.firstColumn = firstColumn;
+    frame.columnCount = columnCount;
+    signal->frames.Publish();
+    SDL_SemPost(signal->ready);
 }
 
-void RenderGraphics(CPU::State8080 *state, milliseconds startingTime, milliseconds currentTime, Renderer8080 *vRender)
+// Draws every published frame, once per emulated vblank or twice when racing the beam. If drawing
+// falls behind, the frames it missed are skipped
+void RenderGraphics(Renderer8080 *vRender)
 {
-    const int frameTime = 100;
-    while (!quit)
+    while (true)
     {
-        currentTime = duration_cast<milliseconds>(chrono::system_clock::now().time_since_epoch());
-        if (currentTime.count() - startingTime.count() > frameTime)
+        SDL_SemWait(frameSignal.ready);
+        // posts for frames already overwritten by newer ones. Quit is set before its post, so
+        // it is seen here even if this loop took that post
+        while (SDL_SemTryWait(frameSignal.ready) == 0)
+        {
+        }
+        if (quit)
         {
-            vRender->RenderPixels(state);
-            startingTime = duration_cast<milliseconds>(chrono::system_clock::now().time_since_epoch());
+            return;
+        }
+        if (frameSignal.frames.Update())
+        {
+            const VramFrame &frame = frameSignal.frames.Front();
+            vRender->RenderVram(frame.vram, frame.firstColumn, frame.columnCount);
         }
     }
 }
 
 int main(int argc, char **argv)
 {
-    int done = 0;
     CPU::State8080 *state = Init8080();
     SDL_Init(SDL_INIT_VIDEO);
     SDL_Event event;
@@ -72,42 +92,72 @@ int main(int argc, char **argv)
     // store the beginning of the memory for state
     uint8_t *mem_start = state->mem;
     // load the rom files into memory
-    ReadFileIntoMemoryAt(state, "ROM/invaders.h", 0);
-    ReadFileIntoMemoryAt(state, "ROM/invaders.g", 0x800);
-    ReadFileIntoMemoryAt(state, "ROM/invaders.f", 0x1000);
-    ReadFileIntoMemoryAt(state, "ROM/invaders.e", 0x1800);
+    LoadInvadersRom(state);
     // we need an instance of CPU to call the Emulator8080 codes
     CPU cpu_instance;
-    // Run rendering on RenderThread
-    milliseconds startingTime, currentTime = duration_cast<milliseconds>(chrono::system_clock::now().time_since_epoch());
+    // the threaded core is the default, "--core switch" runs the reference opcode switch,
+    // "--core blocks" the pre-decoded block cache, "--core jit" the x86-64 translator and
+    // "--core aot" the recompiled ROM when a file generated by the recompiler is built in
+    cpu_instance.SetCore(CPU::ThreadedCore);
+    // "--beam" draws each half of the screen as soon as the emulated beam has passed it,
+    // "--synth" makes the sounds instead of playing the samples in sounds/
+    bool synthesizedSound = false;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "--beam") == 0)
+        {
+            frameSignal.beamRacing = true;
+        }
+        if (strcmp(argv[arg], "--synth") == 0)
+        {
+            synthesizedSound = true;
+        }
+    }
+    for (int arg = 1; arg + 1 < argc; arg++)
+    {
+        CPU::CoreType core;
+        if (strcmp(argv[arg], "--core") == 0 && CPU::CoreFromName(argv[arg + 1], core))
+        {
+            cpu_instance.SetCore(core);
+        }
+    }
+    // Run rendering on RenderThread, woken at every vblank (and mid-screen with --beam)
     Renderer8080 *vRender = new Renderer8080();
     vRender->init();
-    thread RenderThread(RenderGraphics, state, startingTime, currentTime, vRender);
+    frameSignal.ready = SDL_CreateSemaphore(0);
+    cpu_instance.SetInterruptHook(PublishFrame, &frameSignal);
+    thread RenderThread(RenderGraphics, vRender);
     // Run CPU on Main Thread
-    CPU::AudioBootup();
-    int i;
-    while (done == 0)
+    SoundPlayer8080 soundPlayer;
+    soundPlayer.AudioBootup(synthesizedSound);
+    cpu_instance.SetSoundHook(SoundPlayer8080::SoundHook, &soundPlayer);
+    // one emulated frame lasts CyclesPerFrame / ClockSpeed seconds of real time
+    const nanoseconds frameDuration(1000000000LL * CPU::CyclesPerFrame / CPU::ClockSpeed);
+    steady_clock::time_point nextFrame = steady_clock::now();
+    while (!quit)
     {
-        i = 0;
-        while (i < 10000 && !state->halted)
-        {
-            i++;
-            done = cpu_instance.Emulate8080Codes(state);
-        }
-        cpu_instance.PerformInterrupt(state);
+        cpu_instance.RunFrame(state);
         while (SDL_PollEvent(&event))
         {
             if (event.type == SDL_QUIT)
             {
-                done = 1;
                 quit = true;
             }
             portLoader.PortLoader(state, event);
         }
-        this_thread::sleep_for(milliseconds(15));
+        // sleep until the frame is due, if we have fallen behind don't try to catch up
+        nextFrame += frameDuration;
+        steady_clock::time_point now = steady_clock::now();
+        if (nextFrame < now)
+        {
+            nextFrame = now;
+        }
+        this_thread::sleep_until(nextFrame);
     }
+    SDL_SemPost(frameSignal.ready);
     RenderThread.join();
-    CPU::AudioTearDown();
+    SDL_DestroySemaphore(frameSignal.ready);
+    soundPlayer.AudioTearDown();
     vRender->destory();
     SDL_Quit();
     free(mem_start);
@@ -0,0 +1,88 @@
+#include "memory_map.h"
+
+MemoryMap::MemoryMap(uint8_t *mem) : mem(mem)
+{
+    for (int page = 0; page < PageCount; page++)
+    {
+        handlers[page] = {nullptr, nullptr, nullptr, nullptr};
+    }
+    MapRam(0, 0x10000, mem);
+}
+
+// Ranges are whole pages, start and size are rounded out to page boundaries
+void MemoryMap::MapRam(uint16_t start, int size, uint8_t *target)
+{
+    int first = start >> PageShift;
+    int last = (start + size - 1) >> PageShift;
+    for (int page = first; page <= last; page++)
+    {
+        readPages[page] = target + (page - first) * PageSize;
+        writePages[page] = target + (page - first) * PageSize;
+    }
+}
+
+void MemoryMap::MapRom(uint16_t start, int size, const uint8_t *target)
+{
+    int first = start >> PageShift;
+    int last = (start + size - 1) >> PageShift;
+    for (int page = first; page <= last; page++)
+    {
+        readPages[page] = target + (page - first) * PageSize;
+        writePages[page] = nullptr;
+        handlers[page].write = nullptr;
+    }
+}
+
+void MemoryMap::SetHandlers(uint16_t start, int size, ReadHandler read, WriteHandler write, void *context)
+{
+    int first = start >> PageShift;
+    int last = (start + size - 1) >> PageShift;
+    for (int page = first; page <= last; page++)
+    {
+        if (read)
+        {
+            readPages[page] = nullptr;
+            handlers[page].read = read;
+            handlers[page].readContext = context;
+        }
+        if (write)
+        {
+            writePages[page] = nullptr;
+            handlers[page].write = write;
+            handlers[page].writeContext = context;
+        }
+    }
+}
+
+void MemoryMap::MapInvadersBoard()
+{
+    MapRom(0x0000, 0x2000, mem);
+    MirrorInvadersRam();
+}
+
+void MemoryMap::MirrorInvadersRam()
+{
+    for (int mirror = 0x2000; mirror < 0x10000; mirror += 0x2000)
+    {
+        MapRam(uint16_t(mirror), 0x2000, mem + 0x2000);
+    }
+}
+
+uint8_t MemoryMap::ReadSlow(uint16_t address)
+{
+    const PageHandlers &page = handlers[address >> PageShift];
+    if (page.read)
+    {
+        return page.read(page.readContext, address);
+    }
+    return 0xFF;
+}
+
+void MemoryMap::WriteSlow(uint16_t address, uint8_t value)
+{
+    const PageHandlers &page = handlers[address >> PageShift];
+    if (page.write)
+    {
+        page.write(page.writeContext, address, value);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+// 64K address space split into 256 byte pages for the switch core (CPU::SetMemoryMap).
+// Every page has a read pointer and a write pointer. Plain RAM and ROM pages point straight at
+// their bytes, so an access is one table load and a null check before the usual array index.
+// Pages whose pointer is null go through the page's handlers instead, which is how write
+// protection, mirrors onto other memory, video RAM tracking and watchpoints are set up without
+// touching the opcode cases. A null pointer with no handler reads as 0xFF and drops writes
+class MemoryMap {
+
+public:
+    static const int PageShift = 8;
+    static const int PageSize = 1 << PageShift;
+    static const int PageCount = 0x10000 / PageSize;
+
+    typedef uint8_t (*ReadHandler)(void *context, uint16_t address);
+    typedef void (*WriteHandler)(void *context, uint16_t address, uint8_t value);
+
+    // Starts with the whole address space as plain RAM over mem, which is what the cores
+    // did before there was a map
+    explicit MemoryMap(uint8_t *mem);
+
+    // Pages covering [start, start + size) read and write target. target can be anywhere,
+    // pointing it at another part of mem makes the range a mirror of it
+    void MapRam(uint16_t start, int size, uint8_t *target);
+
+    // Pages covering [start, start + size) read target and ignore writes
+    void MapRom(uint16_t start, int size, const uint8_t *target);
+
+    // Sends reads and/or writes for the range to handlers, a null handler leaves that side of
+    // the page as it was. A watch that still wants the access to happen does it in the handler
+    void SetHandlers(uint16_t start, int size, ReadHandler read, WriteHandler write, void *context);
+
+    // The Space Invaders board: 8K ROM at 0x0000 that ignores writes, 8K RAM at 0x2000 and that
+    // RAM again every 8K from 0x4000 up
+    void MapInvadersBoard();
+
+    // Only the board's RAM mirrors, the ROM stays writable like a machine from MachineMemory
+    void MirrorInvadersRam();
+
+    uint8_t Read(uint16_t address)
+    {
+        const uint8_t *page = readPages[address >> PageShift];
+        if (page)
+        {
+            return page[address & (PageSize - 1)];
+        }
+        return ReadSlow(address);
+    }
+
+    void Write(uint16_t address, uint8_t value)
+    {
+        uint8_t *page = writePages[address >> PageShift];
+        if (page)
+        {
+            page[address & (PageSize - 1)] = value;
+            return;
+        }
+        WriteSlow(address, value);
+    }
+
+private:
+    typedef struct PageHandlers {
+        ReadHandler read;
+        WriteHandler write;
+        void *readContext;
+        void *writeContext;
+    } PageHandlers;
+
+    uint8_t *mem;
+    const uint8_t *readPages[PageCount];
+    uint8_t *writePages[PageCount];
+    PageHandlers handlers[PageCount];
+
+    uint8_t ReadSlow(uint16_t address);
+    void WriteSlow(uint16_t address, uint8_t value);
+};
@@ -0,0 +1,81 @@
+#include <mutex>
+#include "recompiled_core.h"
+
+// Plain pointer so registration works no matter which static initializer runs first
+static const RecompiledProgram *registeredProgram = nullptr;
+
+// Block function for each start address, filled in once the ROM has been checked
+static RecompiledFunction blockAt[0x10000];
+static uint16_t blockCycles[0x10000];
+static std::once_flag tablesFilled;
+
+void RegisterRecompiledProgram(const RecompiledProgram *program)
+{
+    registeredProgram = program;
+}
+
+const RecompiledProgram *GetRecompiledProgram()
+{
+    return registeredProgram;
+}
+
+uint32_t RecompiledRomChecksum(const uint8_t *mem, uint16_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (int address = 0; address < size; address++)
+    {
+        hash = (hash ^ mem[address]) * 16777619u;
+    }
+    return hash;
+}
+
+// Fills the lookup tables when the loaded ROM is the one the program was generated from
+static bool LoadRecompiledProgram(const uint8_t *mem)
+{
+    const RecompiledProgram *program = registeredProgram;
+    if (!program || RecompiledRomChecksum(mem, program->romSize) != program->romChecksum)
+    {
+        return false;
+    }
+    // every machine in a MachinePool can get here at the same time, only the first fills the tables
+    std::call_once(tablesFilled, [program]()
+    {
+        for (int index = 0; index < program->count; index++)
+        {
+            blockAt[program->blocks[index].address] = program->blocks[index].run;
+            blockCycles[program->blocks[index].address] = program->blocks[index].maxCycles;
+        }
+    });
+    return true;
+}
+
+// Runs recompiled blocks until state->cycles reaches target or the cpu halts.
+// Like the jit, a block only runs when it is sure to finish before target, otherwise the
+// interpreter steps up to it, so interrupts land on the same instruction as on the other cores
+void CPU::RunRecompiled(State8080 *state, uint64_t target)
+{
+    if (!recompiledChecked)
+    {
+        recompiledLoaded = LoadRecompiledProgram(state->mem);
+        recompiledChecked = true;
+    }
+    ResolveLazyFlags(state);
+
+    uint64_t cycles = state->cycles;
+    while (cycles < target && !state->halted)
+    {
+        // OUT stamps sound port changes with state->cycles, a block adds the OUT's offset to it
+        state->cycles = cycles;
+        RecompiledFunction run = recompiledLoaded ? blockAt[state->pc] : nullptr;
+        if (run && cycles + blockCycles[state->pc] <= target)
+        {
+            cycles += run(this, state);
+        }
+        else
+        {
+            cycles += Emulate8080Codes(state);
+            ResolveLazyFlags(state);
+        }
+    }
+    state->cycles = cycles;
+}
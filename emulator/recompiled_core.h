@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include "emulator_shell.h"
+#include "alu8080.h"
+
+// Runtime side of the ahead-of-time recompiler (recompiler.cpp).
+// The recompiler turns every block of ROM code it can trace into a C++ function and writes them
+// out with a table of RecompiledBlock entries. Building that file into the emulator registers the
+// table before main runs; RecompiledCore then calls a block's function whenever pc lands on it
+// and hands everything else (RAM code, PCHL targets it never saw) to the interpreter.
+// Without a generated file linked in RecompiledCore is just the switch core
+
+typedef int (*RecompiledFunction)(CPU *cpu, CPU::State8080 *state);
+
+typedef struct RecompiledBlock {
+    uint16_t address;
+    uint16_t maxCycles; // cycles with a taken Ccc/Rcc at the end, the block only runs if they fit
+    RecompiledFunction run;
+} RecompiledBlock;
+
+typedef struct RecompiledProgram {
+    const RecompiledBlock *blocks;
+    int count;
+    uint16_t romSize;     // bytes of ROM the blocks were traced from, starting at 0x0000
+    uint32_t romChecksum; // FNV-1a of those bytes, the blocks are only used on the same ROM
+} RecompiledProgram;
+
+void RegisterRecompiledProgram(const RecompiledProgram *program);
+
+const RecompiledProgram *GetRecompiledProgram();
+
+uint32_t RecompiledRomChecksum(const uint8_t *mem, uint16_t size);
+
+// The generated file defines one of these to register its table during static initialization
+struct RecompiledRegistration {
+    RecompiledRegistration(const RecompiledProgram *program)
+    {
+        RegisterRecompiledProgram(program);
+    }
+};
+
+// Helpers for the generated code. They follow the interpreter's conventions: CALL pushes the
+// address of its own last byte, RST its own address, and RET adds one to what it pops
+
+inline void RecompiledPush(CPU::State8080 *state, uint16_t value)
+{
+    state->mem[uint16_t(state->sp - 1)] = value >> 8;
+    state->mem[uint16_t(state->sp - 2)] = value & 0xFF;
+    state->sp -= 2;
+}
+
+inline uint16_t RecompiledPop(CPU::State8080 *state)
+{
+    uint16_t value = state->mem[state->sp] | (state->mem[uint16_t(state->sp + 1)] << 8);
+    state->sp += 2;
+    return value;
+}
+
+inline void RecompiledReturn(CPU::State8080 *state)
+{
+    state->pc = RecompiledPop(state) + 1;
+}
+
+inline void RecompiledDoubleAdd(CPU::State8080 *state, uint16_t value)
+{
+    uint32_t result = state->hl + value;
+    state->hl = uint16_t(result);
+    state->flags = (state->flags & ~FlagCY) | (result >> 16);
+}
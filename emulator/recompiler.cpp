@@ -0,0 +1,364 @@
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#include "emulator_shell.h"
+#include "disassembler.h"
+#include "recompiled_core.h"
+#include "rom_loader.h"
+
+using namespace std;
+
+// Ahead-of-time recompiler for the Space Invaders ROM.
+// Traces every instruction reachable from the reset vector and the RST 1 / RST 2 interrupt
+// vectors, following jumps, calls, RSTs and the addresses returns come back to, and writes each
+// block of straight-line code out as a C++ function working on State8080 (see recompiled_core.h).
+// The disassembly of everything it traced goes to stdout. It links the cpu cores for the
+// opcode cycle table and the ROM loader:
+//   g++ -std=c++17 -O2 recompiler.cpp emulator_shell.cpp recompiled_core.cpp threaded_core.cpp
+//       block_cache.cpp jit_x64.cpp memory_map.cpp disassembler.cpp rom_loader.cpp -o recompiler
+// Usage, from the directory holding ROM/: recompiler <output.cpp>
+// then build the output into the emulator and run it with "--core aot"
+
+static const uint16_t RomSize = 0x2000;
+static const int MaxBlockInstructions = 64;
+
+// Index order is the 8080 encoding: B C D E H L M A
+static const char *RegisterName[8] = {
+    "state->b", "state->c", "state->d", "state->e",
+    "state->h", "state->l", "state->mem[state->hl]", "state->a"};
+
+// BC DE HL
+static const char *PairName[3] = {"state->bc", "state->de", "state->hl"};
+
+// NZ Z NC C PO PE P M
+static const char *ConditionText[8] = {
+    "!(state->flags & FlagZ)", "(state->flags & FlagZ)",
+    "!(state->flags & FlagCY)", "(state->flags & FlagCY)",
+    "!(state->flags & FlagP)", "(state->flags & FlagP)",
+    "!(state->flags & FlagS)", "(state->flags & FlagS)"};
+
+// ADD ADC SUB SBB ANA XRA ORA CMP
+static const char *AluText[8] = {
+    "AluAdd(state, %s, 0);", "AluAdd(state, %s, state->flags & FlagCY);",
+    "AluSubtract(state, %s, 0);", "AluSubtract(state, %s, state->flags & FlagCY);",
+    "AluAnd(state, %s);", "AluXor(state, %s);", "AluOr(state, %s);", "AluCompare(state, %s);"};
+
+typedef struct TracedBlock {
+    uint16_t start;
+    uint16_t maxCycles;
+    bool usesCpu; // IN and OUT call back into the interpreter
+    string body;
+} TracedBlock;
+
+static string Format(const char *format, ...)
+{
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    return string(text);
+}
+
+// C++ for the instruction at address. cycles is the block's total once this instruction has run,
+// which is what every exit returns. Sets endsBlock for control flow and adds the addresses
+// execution can continue at to successors
+static string TranslateInstruction(const uint8_t *mem, uint16_t address, int cycles, bool &endsBlock,
+                                   bool &usesCpu, vector<uint16_t> &successors)
+{
+    uint8_t opcode = mem[address];
+    uint8_t imm8 = mem[uint16_t(address + 1)];
+    uint16_t imm16 = mem[uint16_t(address + 1)] | (mem[uint16_t(address + 2)] << 8);
+    int dstIndex = (opcode >> 3) & 7;
+    int srcIndex = opcode & 7;
+    int pairIndex = (opcode >> 4) & 3;
+    const char *dst = RegisterName[dstIndex];
+    const char *src = RegisterName[srcIndex];
+
+    endsBlock = false;
+    if (opcode == 0x76)
+    {
+        endsBlock = true;
+        successors.push_back(address + 1); // where the interrupt handler returns to
+        return Format("state->halted = true;\n    state->pc = 0x%04x;\n    return %d;", address + 1, cycles);
+    }
+    if (opcode >= 0x40 && opcode < 0x80)
+    {
+        return Format("%s = %s;", dst, src);
+    }
+    if (opcode >= 0x80 && opcode < 0xC0)
+    {
+        return Format(AluText[dstIndex], src);
+    }
+    if (opcode < 0x40)
+    {
+        switch (opcode & 0x0F)
+        {
+        case 0x00:
+        case 0x08:
+            return "";
+        case 0x01:
+            if (pairIndex == 3)
+                return Format("state->sp = 0x%04x;", imm16);
+            return Format("%s = 0x%04x;", PairName[pairIndex], imm16);
+        case 0x03:
+        case 0x0B:
+        {
+            const char *change = (opcode & 0x08) ? "-= 1" : "+= 1";
+            return Format("%s %s;", pairIndex == 3 ? "state->sp" : PairName[pairIndex], change);
+        }
+        case 0x09:
+            return Format("RecompiledDoubleAdd(state, %s);", pairIndex == 3 ? "state->sp" : PairName[pairIndex]);
+        case 0x04:
+        case 0x0C:
+            return Format("%s = AluIncrement(state, %s);", dst, dst);
+        case 0x05:
+        case 0x0D:
+            return Format("%s = AluDecrement(state, %s);", dst, dst);
+        case 0x06:
+        case 0x0E:
+            return Format("%s = 0x%02x;", dst, imm8);
+        }
+        switch (opcode)
+        {
+        case 0x02:
+        case 0x12:
+            return Format("state->mem[%s] = state->a;", PairName[pairIndex]);
+        case 0x0A:
+        case 0x1A:
+            return Format("state->a = state->mem[%s];", PairName[pairIndex]);
+        case 0x22:
+            return Format("state->mem[0x%04x] = state->l;\n    state->mem[0x%04x] = state->h;", imm16, uint16_t(imm16 + 1));
+        case 0x2A:
+            return Format("state->l = state->mem[0x%04x];\n    state->h = state->mem[0x%04x];", imm16, uint16_t(imm16 + 1));
+        case 0x32:
+            return Format("state->mem[0x%04x] = state->a;", imm16);
+        case 0x3A:
+            return Format("state->a = state->mem[0x%04x];", imm16);
+        case 0x07:
+            return "state->flags = (state->flags & ~FlagCY) | (state->a >> 7);\n"
+                   "    state->a = uint8_t((state->a << 1) | (state->a >> 7));";
+        case 0x0F:
+            return "state->flags = (state->flags & ~FlagCY) | (state->a & 1);\n"
+                   "    state->a = uint8_t((state->a >> 1) | (state->a << 7));";
+        case 0x17:
+        {
+            return "{\n"
+                   "        uint8_t carry = state->flags & FlagCY;\n"
+                   "        state->flags = (state->flags & ~FlagCY) | (state->a >> 7);\n"
+                   "        state->a = uint8_t((state->a << 1) | carry);\n"
+                   "    }";
+        }
+        case 0x1F:
+        {
+            return "{\n"
+                   "        uint8_t carry = state->flags & FlagCY;\n"
+                   "        state->flags = (state->flags & ~FlagCY) | (state->a & 1);\n"
+                   "        state->a = uint8_t((state->a >> 1) | (carry << 7));\n"
+                   "    }";
+        }
+        case 0x27:
+            return "AluDecimalAdjust(state);";
+        case 0x2F:
+            return "state->a = ~state->a;";
+        case 0x37:
+            return "state->flags |= FlagCY;";
+        case 0x3F:
+            return "state->flags ^= FlagCY;";
+        }
+    }
+
+    // 0xC0 - 0xFF
+    uint16_t next = address + 1;
+    switch (opcode & 0x07)
+    {
+    case 0x00: // Rcc
+        endsBlock = true;
+        successors.push_back(next);
+        return Format("if (%s)\n    {\n        RecompiledReturn(state);\n        return %d;\n    }\n"
+                      "    state->pc = 0x%04x;\n    return %d;",
+                      ConditionText[dstIndex], cycles + 6, next, cycles);
+    case 0x02: // Jcc
+        endsBlock = true;
+        successors.push_back(imm16);
+        successors.push_back(address + 3);
+        return Format("state->pc = %s ? 0x%04x : 0x%04x;\n    return %d;", ConditionText[dstIndex], imm16, address + 3, cycles);
+    case 0x04: // Ccc
+        endsBlock = true;
+        successors.push_back(imm16);
+        successors.push_back(address + 3);
+        return Format("if (%s)\n    {\n        RecompiledPush(state, 0x%04x);\n        state->pc = 0x%04x;\n        return %d;\n    }\n"
+                      "    state->pc = 0x%04x;\n    return %d;",
+                      ConditionText[dstIndex], address + 2, imm16, cycles + 6, address + 3, cycles);
+    case 0x06:
+        return Format(AluText[dstIndex], Format("0x%02x", imm8).c_str());
+    case 0x07: // RST
+        endsBlock = true;
+        successors.push_back(opcode & 0x38);
+        successors.push_back(next);
+        return Format("RecompiledPush(state, 0x%04x);\n    state->pc = 0x%04x;\n    return %d;", address, opcode & 0x38, cycles);
+    }
+    switch (opcode)
+    {
+    case 0xC1:
+    case 0xD1:
+    case 0xE1:
+        return Format("%s = RecompiledPop(state);", PairName[pairIndex & 3]);
+    case 0xF1:
+        return "state->flags = (state->mem[state->sp] & (FlagS | FlagZ | FlagAC | FlagP | FlagCY)) | FlagOne;\n"
+               "    state->a = state->mem[uint16_t(state->sp + 1)];\n    state->sp += 2;";
+    case 0xC5:
+    case 0xD5:
+    case 0xE5:
+        return Format("RecompiledPush(state, %s);", PairName[pairIndex & 3]);
+    case 0xF5:
+        return "RecompiledPush(state, (state->a << 8) | (state->flags & (FlagS | FlagZ | FlagAC | FlagP | FlagCY)) | FlagOne);";
+    case 0xC3:
+    case 0xCB:
+        endsBlock = true;
+        successors.push_back(imm16);
+        return Format("state->pc = 0x%04x;\n    return %d;", imm16, cycles);
+    case 0xCD:
+    case 0xDD:
+    case 0xED:
+    case 0xFD:
+        endsBlock = true;
+        successors.push_back(imm16);
+        successors.push_back(address + 3);
+        return Format("RecompiledPush(state, 0x%04x);\n    state->pc = 0x%04x;\n    return %d;", address + 2, imm16, cycles);
+    case 0xC9:
+    case 0xD9:
+        endsBlock = true;
+        return Format("RecompiledReturn(state);\n    return %d;", cycles);
+    case 0xE9:
+        endsBlock = true;
+        return Format("state->pc = state->hl;\n    return %d;", cycles);
+    case 0xD3:
+    {
+        // state->cycles is the block's start, moving it up to the OUT for the call gives a sound
+        // port change the same cycle stamp as on the switch core
+        usesCpu = true;
+        int offset = cycles - CPU::OpcodeCycles[opcode];
+        return Format("state->pc = 0x%04x;\n    state->cycles += %d;\n    cpu->Emulate8080Codes(state);\n    state->cycles -= %d;",
+                      address, offset, offset);
+    }
+    case 0xDB:
+        // the port handlers live in CPU, so IN and OUT run through the interpreter
+        usesCpu = true;
+        return Format("state->pc = 0x%04x;\n    cpu->Emulate8080Codes(state);", address);
+    case 0xE3:
+        return "{\n"
+               "        uint16_t swapped = state->hl - 1;\n"
+               "        state->l = state->mem[state->sp];\n"
+               "        state->h = state->mem[uint16_t(state->sp + 1)];\n"
+               "        state->mem[state->sp] = uint8_t(swapped);\n"
+               "        state->mem[uint16_t(state->sp + 1)] = swapped >> 8;\n"
+               "    }";
+    case 0xEB:
+        return "{\n"
+               "        uint16_t swap = state->hl;\n"
+               "        state->hl = state->de;\n"
+               "        state->de = swap;\n"
+               "    }";
+    case 0xF9:
+        return "state->sp = state->hl;";
+    case 0xF3:
+        return "state->int_enable = 0;";
+    case 0xFB:
+        return "state->int_enable = 1;";
+    }
+    return "";
+}
+
+// Follows one block from start, printing its disassembly and collecting the generated body
+static TracedBlock TraceBlock(uint8_t *mem, uint16_t start, vector<uint16_t> &successors)
+{
+    TracedBlock block = {start, 0, false, ""};
+    uint16_t address = start;
+    int cycles = 0;
+    bool endsBlock = false;
+    printf("; block 0x%04x\n", start);
+    for (int count = 0; count < MaxBlockInstructions && !endsBlock && address < RomSize; count++)
+    {
+        int length = Disassemble8080Op(mem, address);
+        cycles += CPU::OpcodeCycles[mem[address]];
+        string code = TranslateInstruction(mem, address, cycles, endsBlock, block.usesCpu, successors);
+        block.body += Format("    // 0x%04x\n", address);
+        if (!code.empty())
+        {
+            block.body += "    " + code + "\n";
+        }
+        address += length;
+    }
+    if (!endsBlock)
+    {
+        // ran into the block length limit or off the end of the ROM
+        block.body += Format("    state->pc = 0x%04x;\n    return %d;\n", address, cycles);
+        successors.push_back(address);
+    }
+    // a taken Ccc or Rcc adds 6, the runtime keeps the worst case
+    block.maxCycles = uint16_t(cycles + 6);
+    return block;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: recompiler <output.cpp>\n");
+        return 1;
+    }
+    CPU::State8080 *state = Init8080();
+    memset(state->mem, 0, 0x10000);
+    LoadInvadersRom(state);
+
+    // reset, RST 1 (mid-screen) and RST 2 (vblank)
+    vector<uint16_t> pending = {0x0000, 0x0008, 0x0010};
+    set<uint16_t> traced;
+    vector<TracedBlock> blocks;
+    while (!pending.empty())
+    {
+        uint16_t start = pending.back();
+        pending.pop_back();
+        if (start >= RomSize || traced.count(start))
+        {
+            continue;
+        }
+        traced.insert(start);
+        vector<uint16_t> successors;
+        blocks.push_back(TraceBlock(state->mem, start, successors));
+        pending.insert(pending.end(), successors.begin(), successors.end());
+    }
+
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL)
+    {
+        printf("error: Couldn't open %s\n", argv[1]);
+        return 1;
+    }
+    fprintf(out, "// Generated by recompiler from the Space Invaders ROM, do not edit\n");
+    fprintf(out, "#include \"recompiled_core.h\"\n\n");
+    for (const TracedBlock &block : blocks)
+    {
+        fprintf(out, "static int Block_%04x(CPU *%s, CPU::State8080 *state)\n{\n%s}\n\n",
+                block.start, block.usesCpu ? "cpu" : "", block.body.c_str());
+    }
+    fprintf(out, "static const RecompiledBlock Blocks[] = {\n");
+    for (const TracedBlock &block : blocks)
+    {
+        fprintf(out, "    {0x%04x, %d, Block_%04x},\n", block.start, block.maxCycles, block.start);
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "static const RecompiledProgram Program = {Blocks, %d, 0x%04x, 0x%08xu};\n\n",
+            int(blocks.size()), RomSize, RecompiledRomChecksum(state->mem, RomSize));
+    fprintf(out, "static RecompiledRegistration registration(&Program);\n");
+    fclose(out);
+
+    fprintf(stderr, "%d blocks written to %s\n", int(blocks.size()), argv[1]);
+    free(state->mem);
+    free(state);
+    return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include "emulator_shell.h"
+
+void ReadFileIntoMemoryAt(CPU::State8080 *state, const char *filename, uint32_t offset);
+
+CPU::State8080 *Init8080(void);
+
+void LoadInvadersRom(CPU::State8080 *state);
+
+// Reads the same four roms into an 8K buffer, for machines that share one copy (machine_memory.h)
+void LoadInvadersRomImage(uint8_t *image);
@@ -0,0 +1,919 @@
+#include "emulator_shell.h"
+#include "alu8080.h"
+
+// Second interpreter core, selected with CPU::SetCore(ThreadedCore).
+// Unlike Emulate8080Codes it runs a whole batch of instructions per call, so there is no
+// member call and no return to the scheduler between instructions. With GCC and Clang each
+// opcode jumps straight to the next handler through a table of label addresses (computed goto);
+// other compilers get the same handlers as a switch inside the loop.
+// Results match Emulate8080Codes, including its habit of pushing return addresses one byte
+// short and adding the byte back on RET, so both cores can run the same State8080.
+// Flags are always evaluated eagerly here
+
+#if defined(__GNUC__)
+#define THREADED_DISPATCH 1
+#endif
+
+// Working copy of the registers for one batch. Nothing outside RunThreaded ever sees its
+// address, so unlike State8080 the compiler knows stores through mem can't change it and is
+// free to keep it in host registers for the whole batch
+typedef struct BatchRegisters {
+    REGISTER_PAIR(b, c, bc);
+    REGISTER_PAIR(d, e, de);
+    REGISTER_PAIR(h, l, hl);
+    REGISTER_PAIR(a, flags, psw);
+    uint16_t sp;
+    uint16_t pc;
+} BatchRegisters;
+
+// Runs instructions until state->cycles reaches target or the cpu halts.
+// The registers are loaded into locals here and only written back to state when the batch ends.
+// The port handlers only need A, so IN and OUT just swap that one through state
+void CPU::RunThreaded(State8080 *state, uint64_t target)
+{
+    ResolveLazyFlags(state);
+
+    BatchRegisters regs;
+    regs.bc = state->bc;
+    regs.de = state->de;
+    regs.hl = state->hl;
+    regs.psw = state->psw;
+    regs.sp = state->sp;
+    regs.pc = state->pc;
+
+    uint8_t *mem = state->mem;
+    uint8_t &a = regs.a;
+    uint8_t &b = regs.b;
+    uint8_t &c = regs.c;
+    uint8_t &d = regs.d;
+    uint8_t &e = regs.e;
+    uint8_t &h = regs.h;
+    uint8_t &l = regs.l;
+    uint16_t &bc = regs.bc;
+    uint16_t &de = regs.de;
+    uint16_t &hl = regs.hl;
+    uint8_t &flags = regs.flags;
+    uint16_t &psw = regs.psw;
+    uint16_t &sp = regs.sp;
+    uint16_t &pc = regs.pc;
+    uint64_t cycles = state->cycles;
+    uint8_t opcode;
+
+#define IMM8 mem[uint16_t(pc + 1)]
+#define IMM16 uint16_t(mem[uint16_t(pc + 1)] | (mem[uint16_t(pc + 2)] << 8))
+
+    auto Push = [&](uint16_t value)
+    {
+        mem[uint16_t(sp - 1)] = value >> 8;
+        mem[uint16_t(sp - 2)] = value & 0xFF;
+        sp -= 2;
+    };
+    // CALL pushes the address of its own last byte, RET adds one to get past it
+    auto Call = [&](uint16_t address)
+    {
+        Push(pc + 2);
+        pc = address;
+    };
+    auto Return = [&]()
+    {
+        pc = (mem[sp] | (mem[uint16_t(sp + 1)] << 8)) + 1;
+        sp += 2;
+    };
+    auto DoubleAdd = [&](uint16_t value)
+    {
+        uint32_t result = hl + value;
+        hl = uint16_t(result);
+        flags = (flags & ~FlagCY) | (result >> 16);
+    };
+
+#ifdef THREADED_DISPATCH
+    static void *const dispatchTable[256] = {
+        &&op_0x00, &&op_0x01, &&op_0x02, &&op_0x03, &&op_0x04, &&op_0x05, &&op_0x06, &&op_0x07, &&op_0x08, &&op_0x09, &&op_0x0A, &&op_0x0B, &&op_0x0C, &&op_0x0D, &&op_0x0E, &&op_0x0F,
+        &&op_0x10, &&op_0x11, &&op_0x12, &&op_0x13, &&op_0x14, &&op_0x15, &&op_0x16, &&op_0x17, &&op_0x18, &&op_0x19, &&op_0x1A, &&op_0x1B, &&op_0x1C, &&op_0x1D, &&op_0x1E, &&op_0x1F,
+        &&op_0x20, &&op_0x21, &&op_0x22, &&op_0x23, &&op_0x24, &&op_0x25, &&op_0x26, &&op_0x27, &&op_0x28, &&op_0x29, &&op_0x2A, &&op_0x2B, &&op_0x2C, &&op_0x2D, &&op_0x2E, &&op_0x2F,
+        &&op_0x30, &&op_0x31, &&op_0x32, &&op_0x33, &&op_0x34, &&op_0x35, &&op_0x36, &&op_0x37, &&op_0x38, &&op_0x39, &&op_0x3A, &&op_0x3B, &&op_0x3C, &&op_0x3D, &&op_0x3E, &&op_0x3F,
+        &&op_0x40, &&op_0x41, &&op_0x42, &&op_0x43, &&op_0x44, &&op_0x45, &&op_0x46, &&op_0x47, &&op_0x48, &&op_0x49, &&op_0x4A, &&op_0x4B, &&op_0x4C, &&op_0x4D, &&op_0x4E, &&op_0x4F,
+        &&op_0x50, &&op_0x51, &&op_0x52, &&op_0x53, &&op_0x54, &&op_0x55, &&op_0x56, &&op_0x57, &&op_0x58, &&op_0x59, &&op_0x5A, &&op_0x5B, &&op_0x5C, &&op_0x5D, &&op_0x5E, &&op_0x5F,
+        &&op_0x60, &&op_0x61, &&op_0x62, &&op_0x63, &&op_0x64, &&op_0x65, &&op_0x66, &&op_0x67, &&op_0x68, &&op_0x69, &&op_0x6A, &&op_0x6B, &&op_0x6C, &&op_0x6D, &&op_0x6E, &&op_0x6F,
+        &&op_0x70, &&op_0x71, &&op_0x72, &&op_0x73, &&op_0x74, &&op_0x75, &&op_0x76, &&op_0x77, &&op_0x78, &&op_0x79, &&op_0x7A, &&op_0x7B, &&op_0x7C, &&op_0x7D, &&op_0x7E, &&op_0x7F,
+        &&op_0x80, &&op_0x81, &&op_0x82, &&op_0x83, &&op_0x84, &&op_0x85, &&op_0x86, &&op_0x87, &&op_0x88, &&op_0x89, &&op_0x8A, &&op_0x8B, &&op_0x8C, &&op_0x8D, &&op_0x8E, &&op_0x8F,
+        &&op_0x90, &&op_0x91, &&op_0x92, &&op_0x93, &&op_0x94, &&op_0x95, &&op_0x96, &&op_0x97, &&op_0x98, &&op_0x99, &&op_0x9A, &&op_0x9B, &&op_0x9C, &&op_0x9D, &&op_0x9E, &&op_0x9F,
+        &&op_0xA0, &&op_0xA1, &&op_0xA2, &&op_0xA3, &&op_0xA4, &&op_0xA5, &&op_0xA6, &&op_0xA7, &&op_0xA8, &&op_0xA9, &&op_0xAA, &&op_0xAB, &&op_0xAC, &&op_0xAD, &&op_0xAE, &&op_0xAF,
+        &&op_0xB0, &&op_0xB1, &&op_0xB2, &&op_0xB3, &&op_0xB4, &&op_0xB5, &&op_0xB6, &&op_0xB7, &&op_0xB8, &&op_0xB9, &&op_0xBA, &&op_0xBB, &&op_0xBC, &&op_0xBD, &&op_0xBE, &&op_0xBF,
+        &&op_0xC0, &&op_0xC1, &&op_0xC2, &&op_0xC3, &&op_0xC4, &&op_0xC5, &&op_0xC6, &&op_0xC7, &&op_0xC8, &&op_0xC9, &&op_0xCA, &&op_0xCB, &&op_0xCC, &&op_0xCD, &&op_0xCE, &&op_0xCF,
+        &&op_0xD0, &&op_0xD1, &&op_0xD2, &&op_0xD3, &&op_0xD4, &&op_0xD5, &&op_0xD6, &&op_0xD7, &&op_0xD8, &&op_0xD9, &&op_0xDA, &&op_0xDB, &&op_0xDC, &&op_0xDD, &&op_0xDE, &&op_0xDF,
+        &&op_0xE0, &&op_0xE1, &&op_0xE2, &&op_0xE3, &&op_0xE4, &&op_0xE5, &&op_0xE6, &&op_0xE7, &&op_0xE8, &&op_0xE9, &&op_0xEA, &&op_0xEB, &&op_0xEC, &&op_0xED, &&op_0xEE, &&op_0xEF,
+        &&op_0xF0, &&op_0xF1, &&op_0xF2, &&op_0xF3, &&op_0xF4, &&op_0xF5, &&op_0xF6, &&op_0xF7, &&op_0xF8, &&op_0xF9, &&op_0xFA, &&op_0xFB, &&op_0xFC, &&op_0xFD, &&op_0xFE, &&op_0xFF,
+    };
+#define OPCODE(n) op_##n:
+#define NEXT                                \
+    {                                       \
+        if (cycles >= target)               \
+            goto done;                      \
+        opcode = mem[pc];                   \
+        cycles += OpcodeCycles[opcode];     \
+        goto *dispatchTable[opcode];        \
+    }
+    NEXT
+#else
+#define OPCODE(n) case n:
+#define NEXT continue;
+    while (cycles < target)
+    {
+        opcode = mem[pc];
+        cycles += OpcodeCycles[opcode];
+        switch (opcode)
+        {
+#endif
+
+    OPCODE(0x00) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x01) // LXI B,d16
+        c = mem[uint16_t(pc + 1)]; b = mem[uint16_t(pc + 2)]; pc += 3;
+        NEXT
+    OPCODE(0x02) // STAX B
+        mem[bc] = a; pc += 1;
+        NEXT
+    OPCODE(0x03) // INX B
+        bc += 1; pc += 1;
+        NEXT
+    OPCODE(0x04) // INR B
+        b = AluIncrement(&regs, b); pc += 1;
+        NEXT
+    OPCODE(0x05) // DCR B
+        b = AluDecrement(&regs, b); pc += 1;
+        NEXT
+    OPCODE(0x06) // MVI B,d8
+        b = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x07) // RLC
+        { uint8_t bit = a >> 7; a = uint8_t(a << 1) | bit; flags = (flags & ~FlagCY) | bit; } pc += 1;
+        NEXT
+    OPCODE(0x08) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x09) // DAD B
+        DoubleAdd(bc); pc += 1;
+        NEXT
+    OPCODE(0x0A) // LDAX B
+        a = mem[bc]; pc += 1;
+        NEXT
+    OPCODE(0x0B) // DCX B
+        bc -= 1; pc += 1;
+        NEXT
+    OPCODE(0x0C) // INR C
+        c = AluIncrement(&regs, c); pc += 1;
+        NEXT
+    OPCODE(0x0D) // DCR C
+        c = AluDecrement(&regs, c); pc += 1;
+        NEXT
+    OPCODE(0x0E) // MVI C,d8
+        c = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x0F) // RRC
+        { uint8_t bit = a & 1; a = (a >> 1) | uint8_t(bit << 7); flags = (flags & ~FlagCY) | bit; } pc += 1;
+        NEXT
+    OPCODE(0x10) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x11) // LXI D,d16
+        e = mem[uint16_t(pc + 1)]; d = mem[uint16_t(pc + 2)]; pc += 3;
+        NEXT
+    OPCODE(0x12) // STAX D
+        mem[de] = a; pc += 1;
+        NEXT
+    OPCODE(0x13) // INX D
+        de += 1; pc += 1;
+        NEXT
+    OPCODE(0x14) // INR D
+        d = AluIncrement(&regs, d); pc += 1;
+        NEXT
+    OPCODE(0x15) // DCR D
+        d = AluDecrement(&regs, d); pc += 1;
+        NEXT
+    OPCODE(0x16) // MVI D,d8
+        d = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x17) // RAL
+        { uint8_t bit = a >> 7; a = uint8_t(a << 1) | (flags & FlagCY); flags = (flags & ~FlagCY) | bit; } pc += 1;
+        NEXT
+    OPCODE(0x18) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x19) // DAD D
+        DoubleAdd(de); pc += 1;
+        NEXT
+    OPCODE(0x1A) // LDAX D
+        a = mem[de]; pc += 1;
+        NEXT
+    OPCODE(0x1B) // DCX D
+        de -= 1; pc += 1;
+        NEXT
+    OPCODE(0x1C) // INR E
+        e = AluIncrement(&regs, e); pc += 1;
+        NEXT
+    OPCODE(0x1D) // DCR E
+        e = AluDecrement(&regs, e); pc += 1;
+        NEXT
+    OPCODE(0x1E) // MVI E,d8
+        e = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x1F) // RAR
+        { uint8_t bit = a & 1; a = (a >> 1) | uint8_t((flags & FlagCY) << 7); flags = (flags & ~FlagCY) | bit; } pc += 1;
+        NEXT
+    OPCODE(0x20) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x21) // LXI H,d16
+        l = mem[uint16_t(pc + 1)]; h = mem[uint16_t(pc + 2)]; pc += 3;
+        NEXT
+    OPCODE(0x22) // SHLD a16
+        { uint16_t address = IMM16; mem[address] = l; mem[uint16_t(address + 1)] = h; } pc += 3;
+        NEXT
+    OPCODE(0x23) // INX H
+        hl += 1; pc += 1;
+        NEXT
+    OPCODE(0x24) // INR H
+        h = AluIncrement(&regs, h); pc += 1;
+        NEXT
+    OPCODE(0x25) // DCR H
+        h = AluDecrement(&regs, h); pc += 1;
+        NEXT
+    OPCODE(0x26) // MVI H,d8
+        h = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x27) // DAA
+        AluDecimalAdjust(&regs); pc += 1;
+        NEXT
+    OPCODE(0x28) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x29) // DAD H
+        DoubleAdd(hl); pc += 1;
+        NEXT
+    OPCODE(0x2A) // LHLD a16
+        { uint16_t address = IMM16; l = mem[address]; h = mem[uint16_t(address + 1)]; } pc += 3;
+        NEXT
+    OPCODE(0x2B) // DCX H
+        hl -= 1; pc += 1;
+        NEXT
+    OPCODE(0x2C) // INR L
+        l = AluIncrement(&regs, l); pc += 1;
+        NEXT
+    OPCODE(0x2D) // DCR L
+        l = AluDecrement(&regs, l); pc += 1;
+        NEXT
+    OPCODE(0x2E) // MVI L,d8
+        l = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x2F) // CMA
+        a = ~a; pc += 1;
+        NEXT
+    OPCODE(0x30) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x31) // LXI SP,d16
+        sp = IMM16; pc += 3;
+        NEXT
+    OPCODE(0x32) // STA a16
+        mem[IMM16] = a; pc += 3;
+        NEXT
+    OPCODE(0x33) // INX SP
+        sp += 1; pc += 1;
+        NEXT
+    OPCODE(0x34) // INR M
+        mem[hl] = AluIncrement(&regs, mem[hl]); pc += 1;
+        NEXT
+    OPCODE(0x35) // DCR M
+        mem[hl] = AluDecrement(&regs, mem[hl]); pc += 1;
+        NEXT
+    OPCODE(0x36) // MVI M,d8
+        mem[hl] = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x37) // STC
+        flags |= FlagCY; pc += 1;
+        NEXT
+    OPCODE(0x38) // NOP
+        pc += 1;
+        NEXT
+    OPCODE(0x39) // DAD SP
+        DoubleAdd(sp); pc += 1;
+        NEXT
+    OPCODE(0x3A) // LDA a16
+        a = mem[IMM16]; pc += 3;
+        NEXT
+    OPCODE(0x3B) // DCX SP
+        sp -= 1; pc += 1;
+        NEXT
+    OPCODE(0x3C) // INR A
+        a = AluIncrement(&regs, a); pc += 1;
+        NEXT
+    OPCODE(0x3D) // DCR A
+        a = AluDecrement(&regs, a); pc += 1;
+        NEXT
+    OPCODE(0x3E) // MVI A,d8
+        a = IMM8; pc += 2;
+        NEXT
+    OPCODE(0x3F) // CMC
+        flags ^= FlagCY; pc += 1;
+        NEXT
+    OPCODE(0x40) // MOV B,B
+        pc += 1;
+        NEXT
+    OPCODE(0x41) // MOV B,C
+        b = c; pc += 1;
+        NEXT
+    OPCODE(0x42) // MOV B,D
+        b = d; pc += 1;
+        NEXT
+    OPCODE(0x43) // MOV B,E
+        b = e; pc += 1;
+        NEXT
+    OPCODE(0x44) // MOV B,H
+        b = h; pc += 1;
+        NEXT
+    OPCODE(0x45) // MOV B,L
+        b = l; pc += 1;
+        NEXT
+    OPCODE(0x46) // MOV B,M
+        b = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x47) // MOV B,A
+        b = a; pc += 1;
+        NEXT
+    OPCODE(0x48) // MOV C,B
+        c = b; pc += 1;
+        NEXT
+    OPCODE(0x49) // MOV C,C
+        pc += 1;
+        NEXT
+    OPCODE(0x4A) // MOV C,D
+        c = d; pc += 1;
+        NEXT
+    OPCODE(0x4B) // MOV C,E
+        c = e; pc += 1;
+        NEXT
+    OPCODE(0x4C) // MOV C,H
+        c = h; pc += 1;
+        NEXT
+    OPCODE(0x4D) // MOV C,L
+        c = l; pc += 1;
+        NEXT
+    OPCODE(0x4E) // MOV C,M
+        c = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x4F) // MOV C,A
+        c = a; pc += 1;
+        NEXT
+    OPCODE(0x50) // MOV D,B
+        d = b; pc += 1;
+        NEXT
+    OPCODE(0x51) // MOV D,C
+        d = c; pc += 1;
+        NEXT
+    OPCODE(0x52) // MOV D,D
+        pc += 1;
+        NEXT
+    OPCODE(0x53) // MOV D,E
+        d = e; pc += 1;
+        NEXT
+    OPCODE(0x54) // MOV D,H
+        d = h; pc += 1;
+        NEXT
+    OPCODE(0x55) // MOV D,L
+        d = l; pc += 1;
+        NEXT
+    OPCODE(0x56) // MOV D,M
+        d = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x57) // MOV D,A
+        d = a; pc += 1;
+        NEXT
+    OPCODE(0x58) // MOV E,B
+        e = b; pc += 1;
+        NEXT
+    OPCODE(0x59) // MOV E,C
+        e = c; pc += 1;
+        NEXT
+    OPCODE(0x5A) // MOV E,D
+        e = d; pc += 1;
+        NEXT
+    OPCODE(0x5B) // MOV E,E
+        pc += 1;
+        NEXT
+    OPCODE(0x5C) // MOV E,H
+        e = h; pc += 1;
+        NEXT
+    OPCODE(0x5D) // MOV E,L
+        e = l; pc += 1;
+        NEXT
+    OPCODE(0x5E) // MOV E,M
+        e = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x5F) // MOV E,A
+        e = a; pc += 1;
+        NEXT
+    OPCODE(0x60) // MOV H,B
+        h = b; pc += 1;
+        NEXT
+    OPCODE(0x61) // MOV H,C
+        h = c; pc += 1;
+        NEXT
+    OPCODE(0x62) // MOV H,D
+        h = d; pc += 1;
+        NEXT
+    OPCODE(0x63) // MOV H,E
+        h = e; pc += 1;
+        NEXT
+    OPCODE(0x64) // MOV H,H
+        pc += 1;
+        NEXT
+    OPCODE(0x65) // MOV H,L
+        h = l; pc += 1;
+        NEXT
+    OPCODE(0x66) // MOV H,M
+        h = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x67) // MOV H,A
+        h = a; pc += 1;
+        NEXT
+    OPCODE(0x68) // MOV L,B
+        l = b; pc += 1;
+        NEXT
+    OPCODE(0x69) // MOV L,C
+        l = c; pc += 1;
+        NEXT
+    OPCODE(0x6A) // MOV L,D
+        l = d; pc += 1;
+        NEXT
+    OPCODE(0x6B) // MOV L,E
+        l = e; pc += 1;
+        NEXT
+    OPCODE(0x6C) // MOV L,H
+        l = h; pc += 1;
+        NEXT
+    OPCODE(0x6D) // MOV L,L
+        pc += 1;
+        NEXT
+    OPCODE(0x6E) // MOV L,M
+        l = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x6F) // MOV L,A
+        l = a; pc += 1;
+        NEXT
+    OPCODE(0x70) // MOV M,B
+        mem[hl] = b; pc += 1;
+        NEXT
+    OPCODE(0x71) // MOV M,C
+        mem[hl] = c; pc += 1;
+        NEXT
+    OPCODE(0x72) // MOV M,D
+        mem[hl] = d; pc += 1;
+        NEXT
+    OPCODE(0x73) // MOV M,E
+        mem[hl] = e; pc += 1;
+        NEXT
+    OPCODE(0x74) // MOV M,H
+        mem[hl] = h; pc += 1;
+        NEXT
+    OPCODE(0x75) // MOV M,L
+        mem[hl] = l; pc += 1;
+        NEXT
+    OPCODE(0x76) // HLT
+        state->halted = true; pc += 1; goto done;
+        NEXT
+    OPCODE(0x77) // MOV M,A
+        mem[hl] = a; pc += 1;
+        NEXT
+    OPCODE(0x78) // MOV A,B
+        a = b; pc += 1;
+        NEXT
+    OPCODE(0x79) // MOV A,C
+        a = c; pc += 1;
+        NEXT
+    OPCODE(0x7A) // MOV A,D
+        a = d; pc += 1;
+        NEXT
+    OPCODE(0x7B) // MOV A,E
+        a = e; pc += 1;
+        NEXT
+    OPCODE(0x7C) // MOV A,H
+        a = h; pc += 1;
+        NEXT
+    OPCODE(0x7D) // MOV A,L
+        a = l; pc += 1;
+        NEXT
+    OPCODE(0x7E) // MOV A,M
+        a = mem[hl]; pc += 1;
+        NEXT
+    OPCODE(0x7F) // MOV A,A
+        pc += 1;
+        NEXT
+    OPCODE(0x80) // ADD B
+        AluAdd(&regs, b, 0); pc += 1;
+        NEXT
+    OPCODE(0x81) // ADD C
+        AluAdd(&regs, c, 0); pc += 1;
+        NEXT
+    OPCODE(0x82) // ADD D
+        AluAdd(&regs, d, 0); pc += 1;
+        NEXT
+    OPCODE(0x83) // ADD E
+        AluAdd(&regs, e, 0); pc += 1;
+        NEXT
+    OPCODE(0x84) // ADD H
+        AluAdd(&regs, h, 0); pc += 1;
+        NEXT
+    OPCODE(0x85) // ADD L
+        AluAdd(&regs, l, 0); pc += 1;
+        NEXT
+    OPCODE(0x86) // ADD M
+        AluAdd(&regs, mem[hl], 0); pc += 1;
+        NEXT
+    OPCODE(0x87) // ADD A
+        AluAdd(&regs, a, 0); pc += 1;
+        NEXT
+    OPCODE(0x88) // ADC B
+        AluAdd(&regs, b, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x89) // ADC C
+        AluAdd(&regs, c, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x8A) // ADC D
+        AluAdd(&regs, d, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x8B) // ADC E
+        AluAdd(&regs, e, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x8C) // ADC H
+        AluAdd(&regs, h, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x8D) // ADC L
+        AluAdd(&regs, l, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x8E) // ADC M
+        AluAdd(&regs, mem[hl], flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x8F) // ADC A
+        AluAdd(&regs, a, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x90) // SUB B
+        AluSubtract(&regs, b, 0); pc += 1;
+        NEXT
+    OPCODE(0x91) // SUB C
+        AluSubtract(&regs, c, 0); pc += 1;
+        NEXT
+    OPCODE(0x92) // SUB D
+        AluSubtract(&regs, d, 0); pc += 1;
+        NEXT
+    OPCODE(0x93) // SUB E
+        AluSubtract(&regs, e, 0); pc += 1;
+        NEXT
+    OPCODE(0x94) // SUB H
+        AluSubtract(&regs, h, 0); pc += 1;
+        NEXT
+    OPCODE(0x95) // SUB L
+        AluSubtract(&regs, l, 0); pc += 1;
+        NEXT
+    OPCODE(0x96) // SUB M
+        AluSubtract(&regs, mem[hl], 0); pc += 1;
+        NEXT
+    OPCODE(0x97) // SUB A
+        AluSubtract(&regs, a, 0); pc += 1;
+        NEXT
+    OPCODE(0x98) // SBB B
+        AluSubtract(&regs, b, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x99) // SBB C
+        AluSubtract(&regs, c, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x9A) // SBB D
+        AluSubtract(&regs, d, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x9B) // SBB E
+        AluSubtract(&regs, e, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x9C) // SBB H
+        AluSubtract(&regs, h, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x9D) // SBB L
+        AluSubtract(&regs, l, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x9E) // SBB M
+        AluSubtract(&regs, mem[hl], flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0x9F) // SBB A
+        AluSubtract(&regs, a, flags & FlagCY); pc += 1;
+        NEXT
+    OPCODE(0xA0) // ANA B
+        AluAnd(&regs, b); pc += 1;
+        NEXT
+    OPCODE(0xA1) // ANA C
+        AluAnd(&regs, c); pc += 1;
+        NEXT
+    OPCODE(0xA2) // ANA D
+        AluAnd(&regs, d); pc += 1;
+        NEXT
+    OPCODE(0xA3) // ANA E
+        AluAnd(&regs, e); pc += 1;
+        NEXT
+    OPCODE(0xA4) // ANA H
+        AluAnd(&regs, h); pc += 1;
+        NEXT
+    OPCODE(0xA5) // ANA L
+        AluAnd(&regs, l); pc += 1;
+        NEXT
+    OPCODE(0xA6) // ANA M
+        AluAnd(&regs, mem[hl]); pc += 1;
+        NEXT
+    OPCODE(0xA7) // ANA A
+        AluAnd(&regs, a); pc += 1;
+        NEXT
+    OPCODE(0xA8) // XRA B
+        AluXor(&regs, b); pc += 1;
+        NEXT
+    OPCODE(0xA9) // XRA C
+        AluXor(&regs, c); pc += 1;
+        NEXT
+    OPCODE(0xAA) // XRA D
+        AluXor(&regs, d); pc += 1;
+        NEXT
+    OPCODE(0xAB) // XRA E
+        AluXor(&regs, e); pc += 1;
+        NEXT
+    OPCODE(0xAC) // XRA H
+        AluXor(&regs, h); pc += 1;
+        NEXT
+    OPCODE(0xAD) // XRA L
+        AluXor(&regs, l); pc += 1;
+        NEXT
+    OPCODE(0xAE) // XRA M
+        AluXor(&regs, mem[hl]); pc += 1;
+        NEXT
+    OPCODE(0xAF) // XRA A
+        AluXor(&regs, a); pc += 1;
+        NEXT
+    OPCODE(0xB0) // ORA B
+        AluOr(&regs, b); pc += 1;
+        NEXT
+    OPCODE(0xB1) // ORA C
+        AluOr(&regs, c); pc += 1;
+        NEXT
+    OPCODE(0xB2) // ORA D
+        AluOr(&regs, d); pc += 1;
+        NEXT
+    OPCODE(0xB3) // ORA E
+        AluOr(&regs, e); pc += 1;
+        NEXT
+    OPCODE(0xB4) // ORA H
+        AluOr(&regs, h); pc += 1;
+        NEXT
+    OPCODE(0xB5) // ORA L
+        AluOr(&regs, l); pc += 1;
+        NEXT
+    OPCODE(0xB6) // ORA M
+        AluOr(&regs, mem[hl]); pc += 1;
+        NEXT
+    OPCODE(0xB7) // ORA A
+        AluOr(&regs, a); pc += 1;
+        NEXT
+    OPCODE(0xB8) // CMP B
+        AluCompare(&regs, b); pc += 1;
+        NEXT
+    OPCODE(0xB9) // CMP C
+        AluCompare(&regs, c); pc += 1;
+        NEXT
+    OPCODE(0xBA) // CMP D
+        AluCompare(&regs, d); pc += 1;
+        NEXT
+    OPCODE(0xBB) // CMP E
+        AluCompare(&regs, e); pc += 1;
+        NEXT
+    OPCODE(0xBC) // CMP H
+        AluCompare(&regs, h); pc += 1;
+        NEXT
+    OPCODE(0xBD) // CMP L
+        AluCompare(&regs, l); pc += 1;
+        NEXT
+    OPCODE(0xBE) // CMP M
+        AluCompare(&regs, mem[hl]); pc += 1;
+        NEXT
+    OPCODE(0xBF) // CMP A
+        AluCompare(&regs, a); pc += 1;
+        NEXT
+    OPCODE(0xC0) // RNZ
+        if (!(flags & FlagZ)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xC1) // POP B
+        c = mem[sp]; b = mem[uint16_t(sp + 1)]; sp += 2; pc += 1;
+        NEXT
+    OPCODE(0xC2) // JNZ a16
+        pc = (!(flags & FlagZ)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xC3) // JMP a16
+        pc = IMM16;
+        NEXT
+    OPCODE(0xC4) // CNZ a16
+        if (!(flags & FlagZ)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xC5) // PUSH B
+        Push(bc); pc += 1;
+        NEXT
+    OPCODE(0xC6) // ADI d8
+        AluAdd(&regs, IMM8, 0); pc += 2;
+        NEXT
+    OPCODE(0xC7) // RST 0
+        Push(pc); pc = 0x00;
+        NEXT
+    OPCODE(0xC8) // RZ
+        if ((flags & FlagZ)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xC9) // RET
+        Return();
+        NEXT
+    OPCODE(0xCA) // JZ a16
+        pc = ((flags & FlagZ)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xCB) // *JMP a16
+        pc = IMM16;
+        NEXT
+    OPCODE(0xCC) // CZ a16
+        if ((flags & FlagZ)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xCD) // CALL a16
+        Call(IMM16);
+        NEXT
+    OPCODE(0xCE) // ACI d8
+        AluAdd(&regs, IMM8, flags & FlagCY); pc += 2;
+        NEXT
+    OPCODE(0xCF) // RST 1
+        Push(pc); pc = 0x08;
+        NEXT
+    OPCODE(0xD0) // RNC
+        if (!(flags & FlagCY)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xD1) // POP D
+        e = mem[sp]; d = mem[uint16_t(sp + 1)]; sp += 2; pc += 1;
+        NEXT
+    OPCODE(0xD2) // JNC a16
+        pc = (!(flags & FlagCY)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xD3) // OUT d8
+        // the sound hook stamps port changes with the cycle the OUT started on, like the switch core
+        state->cycles = cycles - OpcodeCycles[0xD3];
+        HandleOutput(IMM8, a, state); PlayAudio(state); pc += 2;
+        NEXT
+    OPCODE(0xD4) // CNC a16
+        if (!(flags & FlagCY)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xD5) // PUSH D
+        Push(de); pc += 1;
+        NEXT
+    OPCODE(0xD6) // SUI d8
+        AluSubtract(&regs, IMM8, 0); pc += 2;
+        NEXT
+    OPCODE(0xD7) // RST 2
+        Push(pc); pc = 0x10;
+        NEXT
+    OPCODE(0xD8) // RC
+        if ((flags & FlagCY)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xD9) // *RET
+        Return();
+        NEXT
+    OPCODE(0xDA) // JC a16
+        pc = ((flags & FlagCY)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xDB) // IN d8
+        state->a = a; HandleInput(state, IMM8); a = state->a; pc += 2;
+        NEXT
+    OPCODE(0xDC) // CC a16
+        if ((flags & FlagCY)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xDD) // *CALL a16
+        Call(IMM16);
+        NEXT
+    OPCODE(0xDE) // SBI d8
+        AluSubtract(&regs, IMM8, flags & FlagCY); pc += 2;
+        NEXT
+    OPCODE(0xDF) // RST 3
+        Push(pc); pc = 0x18;
+        NEXT
+    OPCODE(0xE0) // RPO
+        if (!(flags & FlagP)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xE1) // POP H
+        l = mem[sp]; h = mem[uint16_t(sp + 1)]; sp += 2; pc += 1;
+        NEXT
+    OPCODE(0xE2) // JPO a16
+        pc = (!(flags & FlagP)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xE3) // XTHL
+        { uint16_t swapped = hl - 1; l = mem[sp]; h = mem[uint16_t(sp + 1)]; mem[sp] = uint8_t(swapped); mem[uint16_t(sp + 1)] = swapped >> 8; } pc += 1;
+        NEXT
+    OPCODE(0xE4) // CPO a16
+        if (!(flags & FlagP)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xE5) // PUSH H
+        Push(hl); pc += 1;
+        NEXT
+    OPCODE(0xE6) // ANI d8
+        AluAnd(&regs, IMM8); pc += 2;
+        NEXT
+    OPCODE(0xE7) // RST 4
+        Push(pc); pc = 0x20;
+        NEXT
+    OPCODE(0xE8) // RPE
+        if ((flags & FlagP)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xE9) // PCHL
+        pc = hl;
+        NEXT
+    OPCODE(0xEA) // JPE a16
+        pc = ((flags & FlagP)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xEB) // XCHG
+        { uint16_t swap = hl; hl = de; de = swap; } pc += 1;
+        NEXT
+    OPCODE(0xEC) // CPE a16
+        if ((flags & FlagP)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xED) // *CALL a16
+        Call(IMM16);
+        NEXT
+    OPCODE(0xEE) // XRI d8
+        AluXor(&regs, IMM8); pc += 2;
+        NEXT
+    OPCODE(0xEF) // RST 5
+        Push(pc); pc = 0x28;
+        NEXT
+    OPCODE(0xF0) // RP
+        if (!(flags & FlagS)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xF1) // POP PSW
+        psw = ((mem[sp] | (mem[uint16_t(sp + 1)] << 8)) & PswMask) | FlagOne; sp += 2; pc += 1;
+        NEXT
+    OPCODE(0xF2) // JP a16
+        pc = (!(flags & FlagS)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xF3) // DI
+        state->int_enable = 0; pc += 1;
+        NEXT
+    OPCODE(0xF4) // CP a16
+        if (!(flags & FlagS)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xF5) // PUSH PSW
+        Push((psw & PswMask) | FlagOne); pc += 1;
+        NEXT
+    OPCODE(0xF6) // ORI d8
+        AluOr(&regs, IMM8); pc += 2;
+        NEXT
+    OPCODE(0xF7) // RST 6
+        Push(pc); pc = 0x30;
+        NEXT
+    OPCODE(0xF8) // RM
+        if ((flags & FlagS)) { Return(); cycles += 6; } else { pc += 1; }
+        NEXT
+    OPCODE(0xF9) // SPHL
+        sp = hl; pc += 1;
+        NEXT
+    OPCODE(0xFA) // JM a16
+        pc = ((flags & FlagS)) ? IMM16 : uint16_t(pc + 3);
+        NEXT
+    OPCODE(0xFB) // EI
+        state->int_enable = 1; pc += 1;
+        NEXT
+    OPCODE(0xFC) // CM a16
+        if ((flags & FlagS)) { Call(IMM16); cycles += 6; } else { pc += 3; }
+        NEXT
+    OPCODE(0xFD) // *CALL a16
+        Call(IMM16);
+        NEXT
+    OPCODE(0xFE) // CPI d8
+        AluCompare(&regs, IMM8); pc += 2;
+        NEXT
+    OPCODE(0xFF) // RST 7
+        Push(pc); pc = 0x38;
+        NEXT
+
+
+#ifndef THREADED_DISPATCH
+        }
+    }
+#endif
+
+done:
+    state->bc = regs.bc;
+    state->de = regs.de;
+    state->hl = regs.hl;
+    state->psw = regs.psw;
+    state->sp = regs.sp;
+    state->pc = regs.pc;
+    state->cycles = cycles;
+
+#undef OPCODE
+#undef NEXT
+#undef IMM8
+#undef IMM16
+}
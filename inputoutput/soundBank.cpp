@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstring>
+#include <SDL.h>
+#include "soundBank.h"
+
+SoundBank8080::SoundBank8080(){}
+
+bool SoundBank8080::Load(const char *directory, int frequency)
+{
+    Free();
+    // decode and convert everything first so the arena is sized once
+    bool loadedAll = true;
+    std::vector<uint8_t> decoded[SoundCount];
+    for (int index = 0; index < SoundCount; index++)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%d.wav", directory, index);
+        SDL_AudioSpec spec;
+        Uint8 *buffer;
+        Uint32 length;
+        if (!SDL_LoadWAV(path, &spec, &buffer, &length))
+        {
+            loadedAll = false;
+            continue;
+        }
+        SDL_AudioCVT cvt;
+        int needed = SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_S16SYS, 1, frequency);
+        if (needed < 0)
+        {
+            SDL_FreeWAV(buffer);
+            loadedAll = false;
+            continue;
+        }
+        decoded[index].assign(buffer, buffer + length);
+        SDL_FreeWAV(buffer);
+        if (needed)
+        {
+            decoded[index].resize(size_t(length) * cvt.len_mult);
+            cvt.buf = decoded[index].data();
+            cvt.len = int(length);
+            SDL_ConvertAudio(&cvt);
+            decoded[index].resize(cvt.len_cvt);
+        }
+    }
+
+    size_t total = 0;
+    for (const std::vector<uint8_t> &pcm : decoded)
+    {
+        total += pcm.size() / sizeof(int16_t);
+    }
+    arena.resize(total);
+    uint32_t offset = 0;
+    for (int index = 0; index < SoundCount; index++)
+    {
+        offsets[index] = offset;
+        frames[index] = uint32_t(decoded[index].size() / sizeof(int16_t));
+        memcpy(arena.data() + offset, decoded[index].data(), frames[index] * sizeof(int16_t));
+        offset += frames[index];
+    }
+    return loadedAll;
+}
+
+void SoundBank8080::Free()
+{
+    arena.clear();
+    arena.shrink_to_fit();
+    memset(offsets, 0, sizeof(offsets));
+    memset(frames, 0, sizeof(frames));
+}
+
+SoundBank8080::Sample SoundBank8080::Get(int index) const
+{
+    Sample sample = {frames[index] ? arena.data() + offsets[index] : nullptr, frames[index]};
+    return sample;
+}
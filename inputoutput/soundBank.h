@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// The ten Space Invaders samples in sounds/, loaded once when audio starts.
+// Every file is decoded and converted to mono 16 bit at the mixer's rate, then all of them are
+// packed into one block of PCM. Playing a sound is pointing a voice at its part of the block:
+// no file access, no decoding and no allocation
+class SoundBank8080 {
+
+public:
+    static const int SoundCount = 10;
+
+    typedef struct Sample {
+        const int16_t *data;
+        uint32_t frames; // 0 if the file didn't load
+    } Sample;
+
+    SoundBank8080();
+
+    // Loads directory/0.wav - 9.wav. Returns false if any failed, the ones that loaded can
+    // still be played
+    bool Load(const char *directory, int frequency);
+    void Free();
+
+    Sample Get(int index) const;
+
+private:
+    std::vector<int16_t> arena;
+    uint32_t offsets[SoundCount] = {};
+    uint32_t frames[SoundCount] = {};
+};
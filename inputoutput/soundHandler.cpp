@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstring>
+#include "soundHandler.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOUND_MIX_SSE2 1
+#endif
+
+// The sample each sound bit plays, bit 0 first. Port 3: UFO (looped), shot, player dying,
+// invader dying, extra life. Port 5: the four fleet steps, UFO hit
+static const int Port3Sounds[5] = {0, 1, 2, 3, 9};
+static const int Port5Sounds[5] = {4, 5, 6, 7, 8};
+
+SoundPlayer8080::SoundPlayer8080(){}
+
+void SoundPlayer8080::AudioBootup(bool synthesize){
+    SDL_InitSubSystem(SDL_INIT_AUDIO);
+    synthesized = synthesize;
+    if(!synthesized){
+        bank.Load("sounds", SampleRate);
+    }
+    SDL_AudioSpec wanted = {};
+    wanted.freq = SampleRate;
+    wanted.format = AUDIO_S16SYS;
+    wanted.channels = 1;
+    wanted.samples = BufferFrames;
+    wanted.callback = AudioCallback;
+    wanted.userdata = this;
+    // no changes allowed, SDL converts if the device wants something else
+    device = SDL_OpenAudioDevice(nullptr, 0, &wanted, nullptr, 0);
+    if (device) {
+        SDL_PauseAudioDevice(device, 0);
+    }
+}
+
+void SoundPlayer8080::AudioTearDown() {
+    if (device) {
+        // waits for a running callback to finish
+        SDL_CloseAudioDevice(device);
+        device = 0;
+    }
+    bank.Free();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+void SoundPlayer8080::SoundHook(CPU::State8080 *state, void *context)
+{
+    static_cast<SoundPlayer8080 *>(context)->QueueEvents(state);
+}
+
+// Runs on the cpu thread after every OUT, so no library calls in here. If the audio callback has
+// fallen 256 changes behind the new one is dropped rather than holding up emulation.
+// state->cycles is the cycle the OUT started on whichever core is running
+void SoundPlayer8080::QueueEvents(CPU::State8080 *state)
+{
+    // the game writes the watchdog port every frame, so this keeps up with emulation
+    emulatedCycles.store(state->cycles, std::memory_order_release);
+    if(state->out_port3 != state->out_port3_prev){
+        events.Push({state->cycles, 3, state->out_port3_prev, state->out_port3});
+        state->out_port3_prev = state->out_port3;
+    }
+    if(state->out_port5 != state->out_port5_prev){
+        events.Push({state->cycles, 5, state->out_port5_prev, state->out_port5});
+        state->out_port5_prev = state->out_port5;
+    }
+}
+
+uint64_t SoundPlayer8080::FrameAt(uint64_t cycle)
+{
+    return cycle * SampleRate / CPU::ClockSpeed;
+}
+
+void SoundPlayer8080::AudioCallback(void *context, Uint8 *stream, int length)
+{
+    SoundPlayer8080 *player = static_cast<SoundPlayer8080 *>(context);
+    int frames = length / int(sizeof(int16_t));
+    uint64_t emulatedFrame = FrameAt(player->emulatedCycles.load(std::memory_order_acquire));
+    // emulation runs a frame at a time, so the emulated present jumps ahead of real time and falls
+    // back again. Only line up again when the audio has got ahead of it, when events could be
+    // missed, or trails it by more than twice the latency
+    if(player->renderedFrames > emulatedFrame || player->renderedFrames + 2 * LatencyFrames < emulatedFrame){
+        player->renderedFrames = emulatedFrame > LatencyFrames ? emulatedFrame - LatencyFrames : 0;
+    }
+    player->Render((int16_t *)stream, frames);
+}
+
+void SoundPlayer8080::Render(int16_t *out, int frames)
+{
+    uint64_t endFrame = renderedFrames + frames;
+    int done = 0;
+    while(hasPending || events.Pop(pending)){
+        hasPending = true;
+        uint64_t frame = FrameAt(pending.cycle);
+        if(frame >= endFrame){
+            break;
+        }
+        // an event from before this buffer (after lining up again) starts at its beginning
+        int offset = frame > renderedFrames ? std::max(done, int(frame - renderedFrames)) : done;
+        Mix(out + done, offset - done);
+        done = offset;
+        PlayEvent(pending);
+        hasPending = false;
+    }
+    Mix(out + done, frames - done);
+    renderedFrames = endFrame;
+}
+
+// A rising bit starts its sound from the beginning, the UFO also stops when its bit falls
+void SoundPlayer8080::PlayEvent(const AudioEvent &event)
+{
+    const int *sounds = event.port == 3 ? Port3Sounds : Port5Sounds;
+    uint8_t rising = event.value & ~event.previous;
+    uint8_t falling = event.previous & ~event.value;
+    for(int bit = 0; bit < 5; bit++){
+        Voice &voice = voices[sounds[bit]];
+        bool ufo = event.port == 3 && bit == 0;
+        if(synthesized){
+            if(rising & (1 << bit)){
+                synth.Start(sounds[bit]);
+            }
+            else if(ufo && (falling & 1)){
+                synth.Stop(sounds[bit]);
+            }
+            continue;
+        }
+        if(rising & (1 << bit)){
+            SoundBank8080::Sample sample = bank.Get(sounds[bit]);
+            voice = {sample.data, sample.frames, 0, ufo, sample.frames > 0};
+        }
+        else if(ufo && (falling & 1)){
+            voice.playing = false;
+        }
+    }
+}
+
+// Adds in to out with 16 bit saturation, 8 samples at a time where SSE2 is there
+static void MixSamples(int16_t *out, const int16_t *in, int count)
+{
+    int index = 0;
+#ifdef SOUND_MIX_SSE2
+    for(; index + 8 <= count; index += 8){
+        __m128i sum = _mm_adds_epi16(_mm_loadu_si128((const __m128i *)(out + index)), _mm_loadu_si128((const __m128i *)(in + index)));
+        _mm_storeu_si128((__m128i *)(out + index), sum);
+    }
+#endif
+    for(; index < count; index++){
+        out[index] = int16_t(std::min(32767, std::max(-32768, out[index] + in[index])));
+    }
+}
+
+// Fills out with the playing voices. Render calls it once for each stretch between events
+void SoundPlayer8080::Mix(int16_t *out, int frames)
+{
+    if(synthesized){
+        synth.Generate(out, frames);
+        return;
+    }
+    memset(out, 0, frames * sizeof(int16_t));
+    for(Voice &voice : voices){
+        int done = 0;
+        while(voice.playing && done < frames){
+            int count = int(std::min<uint32_t>(uint32_t(frames - done), voice.frames - voice.position));
+            MixSamples(out + done, voice.data + voice.position, count);
+            done += count;
+            voice.position += count;
+            if(voice.position == voice.frames){
+                voice.position = 0;
+                voice.playing = voice.looping;
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <SDL.h>
+#include "../emulator/emulator_shell.h"
+#include "soundBank.h"
+#include "soundSynth.h"
+#include "spscRing.h"
+
+// One change of a sound port, stamped with the cpu cycle count at the OUT that made it
+typedef struct AudioEvent {
+    uint64_t cycle;
+    uint8_t port;     // 3 or 5
+    uint8_t previous; // port value before the OUT
+    uint8_t value;
+} AudioEvent;
+
+// Plays the Space Invaders samples when the game toggles the sound bits on ports 3 and 5.
+// Install it on the cpu with cpu.SetSoundHook(SoundPlayer8080::SoundHook, &player).
+// The samples are all loaded in AudioBootup, see soundBank.h. AudioBootup(true) plays the
+// sounds from SoundSynth8080 instead and loads no files.
+// The hook runs on the cpu thread and only records port changes in a lock-free queue. The SDL
+// audio callback takes them off, starts and stops voices and mixes them itself, one voice per
+// sample with the UFO looping while its bit is set. It never allocates or takes a lock.
+// Output runs on the emulated clock: each event starts its voice on the sample its cpu cycle
+// lands on, so the sound doesn't move with the host's timing. The callback plays LatencyFrames
+// behind the newest cycle the cpu reported, which covers one emulated frame run in a burst plus
+// one buffer, and jumps back into line if emulation stalls or races ahead
+class SoundPlayer8080 {
+
+public:
+    static const int SampleRate = 44100;
+    static const int BufferFrames = 512;
+    static const int LatencyFrames = SampleRate / CPU::FrameRate + BufferFrames;
+
+    SoundPlayer8080();
+    void AudioBootup(bool synthesize);
+    void AudioTearDown();
+    static void SoundHook(CPU::State8080 *state, void *context);
+
+    // Mixes the next frames samples of the emulated timeline, starting every queued event that
+    // falls inside them on its own sample. The audio callback runs it. With no device open it can
+    // be called after each emulated frame instead, and gives the same output for the same run
+    void Render(int16_t *out, int frames);
+
+private:
+    typedef struct Voice {
+        const int16_t *data;
+        uint32_t frames;
+        uint32_t position;
+        bool looping;
+        bool playing;
+    } Voice;
+
+    SoundBank8080 bank;
+    SoundSynth8080 synth{SampleRate};
+    bool synthesized = false;
+    SpscRing<AudioEvent, 256> events;
+    SDL_AudioDeviceID device = 0;
+    std::atomic<uint64_t> emulatedCycles{0}; // newest cycle count seen by the hook
+
+    // audio callback only
+    Voice voices[SoundBank8080::SoundCount] = {};
+    uint64_t renderedFrames = 0; // emulated sample the next Render starts at
+    AudioEvent pending;          // popped but belongs to a later buffer
+    bool hasPending = false;
+
+    static uint64_t FrameAt(uint64_t cycle);
+
+    void QueueEvents(CPU::State8080 *state);
+    static void AudioCallback(void *context, Uint8 *stream, int length);
+    void PlayEvent(const AudioEvent &event);
+    void Mix(int16_t *out, int frames);
+};
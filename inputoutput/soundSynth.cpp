@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+#include "soundSynth.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOUND_SYNTH_SSE2 1
+#endif
+
+typedef struct SynthSound {
+    bool noise;
+    float frequency;   // tone pitch, or how fast the noise shift register is clocked
+    float seconds;     // time for the envelope to fall to a third, 0 to hold until Stop
+    float level;
+    float wobbleRate;  // Hz
+    float wobbleDepth; // fraction of the frequency the pitch swings by
+} SynthSound;
+
+// Pitches and times are by ear against the original board, not taken from its schematic
+static const SynthSound Sounds[SoundSynth8080::SoundCount] = {
+    {false, 520.0f, 0.0f, 0.20f, 6.0f, 0.35f},  // UFO
+    {true, 9000.0f, 0.25f, 0.35f, 0.0f, 0.0f},  // shot
+    {true, 2500.0f, 0.90f, 0.50f, 0.0f, 0.0f},  // player dying
+    {true, 5000.0f, 0.15f, 0.40f, 0.0f, 0.0f},  // invader dying
+    {false, 62.0f, 0.09f, 0.40f, 0.0f, 0.0f},   // fleet step 1
+    {false, 56.0f, 0.09f, 0.40f, 0.0f, 0.0f},   // fleet step 2
+    {false, 50.0f, 0.09f, 0.40f, 0.0f, 0.0f},   // fleet step 3
+    {false, 45.0f, 0.09f, 0.40f, 0.0f, 0.0f},   // fleet step 4
+    {false, 1200.0f, 0.50f, 0.30f, 12.0f, 0.25f}, // UFO hit
+    {false, 1000.0f, 0.60f, 0.20f, 0.0f, 0.0f}, // extra life
+};
+
+static const float ReleaseSeconds = 0.02f; // how fast the UFO stops once its bit is cleared
+static const float Silence = 0.0005f;
+
+SoundSynth8080::SoundSynth8080(int sampleRate) : sampleRate(sampleRate)
+{
+    // 17 bit shift register with feedback from bits 0 and 3, like the noise chips of the time
+    uint32_t shift = 1;
+    for (int index = 0; index < NoiseLength; index++)
+    {
+        uint32_t bit = (shift ^ (shift >> 3)) & 1;
+        shift = (shift >> 1) | (bit << 16);
+        noise[index] = (shift & 1) ? 1.0f : -1.0f;
+    }
+}
+
+void SoundSynth8080::Start(int sound)
+{
+    const SynthSound &setup = Sounds[sound];
+    Voice &voice = voices[sound];
+    voice.phase = 0.0f;
+    voice.step = setup.frequency / float(sampleRate);
+    voice.level = setup.level;
+    voice.decay = setup.seconds > 0.0f ? std::exp(-1.0f / (setup.seconds * float(sampleRate))) : 1.0f;
+    voice.wobble = 0.0f;
+    voice.playing = true;
+}
+
+void SoundSynth8080::Stop(int sound)
+{
+    voices[sound].decay = std::exp(-1.0f / (ReleaseSeconds * float(sampleRate)));
+}
+
+// Square wave, high for the first half of each cycle
+void SoundSynth8080::AddTone(float *mix, int count, Voice &voice, float step)
+{
+    int index = 0;
+#ifdef SOUND_SYNTH_SSE2
+    float decay2 = voice.decay * voice.decay;
+    // phase + step * index for each sample like the scalar loop, so edges land on the same samples
+    const __m128 start = _mm_set1_ps(voice.phase);
+    const __m128 steps = _mm_set1_ps(step);
+    __m128 indices = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 levels = _mm_mul_ps(_mm_set1_ps(voice.level), _mm_setr_ps(1.0f, voice.decay, decay2, decay2 * voice.decay));
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 levelStep = _mm_set1_ps(decay2 * decay2);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (; index + 4 <= count; index += 4)
+    {
+        // phases stay positive so truncating is floor
+        __m128 phases = _mm_add_ps(start, _mm_mul_ps(steps, indices));
+        __m128 cycle = _mm_sub_ps(phases, _mm_cvtepi32_ps(_mm_cvttps_epi32(phases)));
+        __m128 low = _mm_andnot_ps(_mm_cmplt_ps(cycle, half), sign);
+        _mm_storeu_ps(mix + index, _mm_add_ps(_mm_loadu_ps(mix + index), _mm_xor_ps(levels, low)));
+        indices = _mm_add_ps(indices, four);
+        levels = _mm_mul_ps(levels, levelStep);
+    }
+#endif
+    float level = voice.level * std::pow(voice.decay, float(index));
+    for (; index < count; index++)
+    {
+        float phase = voice.phase + step * float(index);
+        mix[index] += phase - std::floor(phase) < 0.5f ? level : -level;
+        level *= voice.decay;
+    }
+    voice.phase += step * float(count);
+    voice.phase -= std::floor(voice.phase);
+}
+
+// The noise table read at the shift register's clock rate, each value held until the next tick
+void SoundSynth8080::AddNoise(float *mix, int count, Voice &voice, float step)
+{
+    const int mask = NoiseLength - 1;
+    int index = 0;
+#ifdef SOUND_SYNTH_SSE2
+    float decay2 = voice.decay * voice.decay;
+    // phases worked out as in AddTone
+    const __m128 start = _mm_set1_ps(voice.phase);
+    const __m128 steps = _mm_set1_ps(step);
+    __m128 indices = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 levels = _mm_mul_ps(_mm_set1_ps(voice.level), _mm_setr_ps(1.0f, voice.decay, decay2, decay2 * voice.decay));
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 levelStep = _mm_set1_ps(decay2 * decay2);
+    const __m128i wrap = _mm_set1_epi32(mask);
+    for (; index + 4 <= count; index += 4)
+    {
+        __m128 phases = _mm_add_ps(start, _mm_mul_ps(steps, indices));
+        alignas(16) int32_t ticks[4];
+        _mm_store_si128((__m128i *)ticks, _mm_and_si128(_mm_cvttps_epi32(phases), wrap));
+        __m128 value = _mm_setr_ps(noise[ticks[0]], noise[ticks[1]], noise[ticks[2]], noise[ticks[3]]);
+        _mm_storeu_ps(mix + index, _mm_add_ps(_mm_loadu_ps(mix + index), _mm_mul_ps(value, levels)));
+        indices = _mm_add_ps(indices, four);
+        levels = _mm_mul_ps(levels, levelStep);
+    }
+#endif
+    float level = voice.level * std::pow(voice.decay, float(index));
+    for (; index < count; index++)
+    {
+        mix[index] += noise[int(voice.phase + step * float(index)) & mask] * level;
+        level *= voice.decay;
+    }
+    voice.phase += step * float(count);
+    voice.phase -= float(NoiseLength) * std::floor(voice.phase / float(NoiseLength));
+}
+
+void SoundSynth8080::Generate(int16_t *out, int frames)
+{
+    while (frames > 0)
+    {
+        int count = std::min(frames, BlockFrames);
+        float mix[BlockFrames] = {};
+        for (int sound = 0; sound < SoundCount; sound++)
+        {
+            Voice &voice = voices[sound];
+            if (!voice.playing)
+            {
+                continue;
+            }
+            const SynthSound &setup = Sounds[sound];
+            float step = voice.step;
+            if (setup.wobbleDepth > 0.0f)
+            {
+                // triangle from -1 to 1 and back, moved on once per block
+                float triangle = 4.0f * std::fabs(voice.wobble - 0.5f) - 1.0f;
+                step *= 1.0f + setup.wobbleDepth * triangle;
+                voice.wobble += setup.wobbleRate * float(count) / float(sampleRate);
+                voice.wobble -= std::floor(voice.wobble);
+            }
+            if (setup.noise)
+            {
+                AddNoise(mix, count, voice, step);
+            }
+            else
+            {
+                AddTone(mix, count, voice, step);
+            }
+            voice.level *= std::pow(voice.decay, float(count));
+            voice.playing = voice.level > Silence;
+        }
+
+        int index = 0;
+#ifdef SOUND_SYNTH_SSE2
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        const __m128 top = _mm_set1_ps(1.0f);
+        const __m128 bottom = _mm_set1_ps(-1.0f);
+        for (; index + 8 <= count; index += 8)
+        {
+            __m128 first = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(mix + index), top), bottom);
+            __m128 second = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(mix + index + 4), top), bottom);
+            __m128i samples = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(first, scale)), _mm_cvtps_epi32(_mm_mul_ps(second, scale)));
+            _mm_storeu_si128((__m128i *)(out + index), samples);
+        }
+#endif
+        for (; index < count; index++)
+        {
+            out[index] = int16_t(std::lrint(std::max(-1.0f, std::min(1.0f, mix[index])) * 32767.0f));
+        }
+        out += count;
+        frames -= count;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// Makes the Space Invaders sounds from nothing instead of playing the samples in sounds/.
+// The board has a discrete circuit for each sound. They are modelled here by what they do rather
+// than component by component: the UFO is an oscillator wobbled by a slow triangle, the shot and
+// the two explosions are noise from a shift register clocked at different rates and dying away,
+// and the four fleet steps are low square tones with a short decay.
+// Sounds are numbered like the samples, 0.wav - 9.wav. Generate works in blocks of BlockFrames:
+// envelopes and the wobble are set once per block and the samples inside it are made 4 at a
+// time with SSE2
+class SoundSynth8080 {
+
+public:
+    static const int SoundCount = 10;
+    static const int BlockFrames = 64;
+
+    explicit SoundSynth8080(int sampleRate);
+
+    // Starts sound from the top. The UFO keeps going until Stop, the others die away by themselves
+    void Start(int sound);
+    void Stop(int sound);
+
+    // Writes frames samples of everything playing
+    void Generate(int16_t *out, int frames);
+
+private:
+    static const int NoiseLength = 8192; // must be a power of two
+
+    typedef struct Voice {
+        float phase;     // through one cycle from 0 to 1, or position in noise for noise sounds
+        float step;      // phase per sample before the wobble
+        float level;     // envelope now
+        float decay;     // envelope multiplier per sample, 1 while the UFO is held
+        float wobble;    // through the wobble triangle from 0 to 1
+        bool playing;
+    } Voice;
+
+    int sampleRate;
+    Voice voices[SoundCount] = {};
+    float noise[NoiseLength]; // +1 or -1
+
+    void AddTone(float *mix, int count, Voice &voice, float step);
+    void AddNoise(float *mix, int count, Voice &voice, float step);
+};
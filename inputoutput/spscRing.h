@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed size queue for one producer thread and one consumer thread, with no locks.
+// The producer only ever writes tail and the consumer only ever writes head, so each side reads
+// the other's index with acquire and publishes its own with release and neither ever waits.
+// Capacity must be a power of two. Push fails when the ring is full instead of blocking
+template <typename T, size_t Capacity>
+class SpscRing {
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    bool Push(const T &item)
+    {
+        size_t tailIndex = tail.load(std::memory_order_relaxed);
+        if (tailIndex - head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+        items[tailIndex & (Capacity - 1)] = item;
+        tail.store(tailIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &item)
+    {
+        size_t headIndex = head.load(std::memory_order_relaxed);
+        if (headIndex == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items[headIndex & (Capacity - 1)];
+        head.store(headIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // the two indices on their own cache lines so the threads don't keep stealing one line
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    T items[Capacity];
+};
@@ -1,47 +1,66 @@
 #include "renderer.h"
+#include <cstring>
 #include <iostream>
 
 using namespace std;
 
 Renderer8080::Renderer8080() {}
 
-/* Render pixels from VRam, scanning from the bottom left to the top right. Each segment of y comprises 8 bits to examine. */
-void Renderer8080::RenderPixels(CPU::State8080* state)
+// Finds the columns whose video RAM changed since they were last drawn. Comparing against a copy
+// of what is on screen catches writes from every core, the JIT and recompiled code included,
+// without a check on each store. Between waves almost nothing changes and nearly every column
+// is skipped
+void Renderer8080::MarkDirtyColumns(const uint8_t* vram, int firstColumn, int columnCount)
 {
-	SDL_RenderClear(sdlRenderer);
-	SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 0);
-	int vRamAddress = 0x2400;
-	// We render from the bottom of column one to the top of column one, then proceed to the next column
-	for (int xPixel = 0; xPixel < XPixelCount; ++xPixel)
+	for (int column = firstColumn; column < firstColumn + columnCount; ++column)
 	{
-		for (int yPixel = 0; yPixel < YPixelCount; yPixel += 8) // increment one byte per pass
+		const uint8_t* bytes = vram + column * VramColumnBytes;
+		uint8_t* shown = &shownVram[column * VramColumnBytes];
+		if (memcmp(bytes, shown, VramColumnBytes) != 0)
 		{
-			uint8_t videoByte = state->mem[vRamAddress];
-			vRamAddress += 1;
+			memcpy(shown, bytes, VramColumnBytes);
+			dirtyColumns.set(column);
+		}
+	}
+}
 
-			// draw the pixels
-			for (int bitIndex = 0; bitIndex < 8; ++bitIndex)
-			{
-				// get the right most bit by itself, if 1 draw pixel is true else false
-				bool drawPixel = videoByte & 0x1;
-				int yPos = (yPixel + 8) + bitIndex;
-				int xPos = xPixel;
-				if (drawPixel)
-				{
-					// draw gameobject color pixel at xPos and yPos
-					SDL_SetRenderDrawColor(sdlRenderer, 255, 255, 255, 255);
-				}
-				else
-				{
-					// draw background color pixel at xPos and yPos
-					SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);
-				}
-				SDL_RenderDrawPoint(sdlRenderer, xPos, YPixelCount - yPos);
-				// so shift right to check the next bit
-				videoByte = videoByte >> 1;
-			}
+/* Render pixels from VRam. Changed columns are converted into the framebuffer 8 at a time, uploaded with one texture update and the texture is drawn to the window with one copy. */
+void Renderer8080::RenderPixels(CPU::State8080* state)
+{
+	RenderVram(&state->mem[VramStart]);
+}
+
+void Renderer8080::RenderVram(const uint8_t* vram, int firstColumn, int columnCount)
+{
+	MarkDirtyColumns(vram, firstColumn, columnCount);
+	int firstChanged = -1;
+	int lastChanged = -1;
+	for (int column = firstColumn; column < firstColumn + columnCount; column += VramConvertBlock)
+	{
+		bool dirty = false;
+		for (int index = column; index < column + VramConvertBlock; ++index)
+		{
+			dirty = dirty || dirtyColumns.test(index);
+		}
+		if (dirty)
+		{
+			converter(vram, column, framebuffer, palette);
+			firstChanged = firstChanged < 0 ? column : firstChanged;
+			lastChanged = column + VramConvertBlock - 1;
+		}
+		for (int index = column; index < column + VramConvertBlock; ++index)
+		{
+			dirtyColumns.reset(index);
 		}
 	}
+	if (firstChanged >= 0)
+	{
+		// one upload covering every changed column
+		SDL_Rect changed = {firstChanged, 0, lastChanged - firstChanged + 1, YPixelCount};
+		SDL_UpdateTexture(frameTexture, &changed, &framebuffer[firstChanged], XPixelCount * sizeof(uint32_t));
+	}
+	SDL_RenderClear(sdlRenderer);
+	SDL_RenderCopy(sdlRenderer, frameTexture, nullptr, nullptr);
 	SDL_RenderPresent(sdlRenderer);
 }
 
@@ -55,10 +74,18 @@ void Renderer8080::init()
 	sdlRenderer = SDL_CreateRenderer(window, 0, 0);
 	SDL_RenderSetLogicalSize(sdlRenderer, XPixelCount, YPixelCount);
 	SDL_SetWindowTitle(window, "INTEL 8080 EMULATOR");
+	frameTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, XPixelCount, YPixelCount);
+	converter = SelectVramConverter();
+	// everything is converted on the first frame
+	dirtyColumns.set();
 }
 
 void Renderer8080::destory()
 {
+	if (frameTexture)
+	{
+		SDL_DestroyTexture(frameTexture);
+	}
 	SDL_DestroyRenderer(sdlRenderer);
 	SDL_DestroyWindow(window);
 }
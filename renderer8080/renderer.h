@@ -1,8 +1,10 @@
 #pragma once
 
+#include <bitset>
 #include <cstdint>
 #include <SDL.h>
 #include "../emulator/emulator_shell.h"
+#include "vram_convert.h"
 
 class Renderer8080 {
 
@@ -13,8 +15,19 @@ public:
     const int YPixelCount = 256;
     const int WindowScaleFactor = 3;
 
+    // Video RAM holds one 32 byte column of 256 pixels for each of the 224 screen columns
+    static const int VramStart = 0x2400;
+    static const int VramColumnBytes = 32;
+    static const int VramColumns = 224;
+
     void RenderPixels(CPU::State8080* state);
 
+    // Same as RenderPixels from a copy of the VramColumns * VramColumnBytes bytes at VramStart.
+    // A band of columns (a multiple of 8 wide) only looks at and redraws those columns, the rest
+    // of the screen stays as it was. Each column is one line of the emulated raster, so racing the
+    // beam is drawing 0 - 111 at the mid-screen interrupt and 112 - 223 at vblank
+    void RenderVram(const uint8_t* vram, int firstColumn = 0, int columnCount = VramColumns);
+
     void init();
 
     void destory();
@@ -23,4 +36,21 @@ public:
     SDL_Renderer* sdlRenderer;
     SDL_Window* window;
 
+    // Colours of lit and dark pixels in the ARGB8888 framebuffer
+    static constexpr uint32_t OnColor = 0xFFFFFFFF;
+    static constexpr uint32_t OffColor = 0xFF000000;
+
+private:
+    // VRAM is expanded into framebuffer, already rotated upright, and uploaded to the streaming
+    // frameTexture. Both keep the screen between frames, so only columns whose bytes changed
+    // since the last present are converted and uploaded again
+    SDL_Texture* frameTexture = nullptr;
+    uint32_t framebuffer[VramColumns * VramColumnBytes * 8] = {};
+    std::bitset<VramColumns> dirtyColumns;
+    uint8_t shownVram[VramColumns * VramColumnBytes] = {};
+    VramConverter converter = ConvertVramScalar; // SIMD when the cpu has it, picked in init
+    const uint32_t palette[2] = {OffColor, OnColor};
+
+    void MarkDirtyColumns(const uint8_t* vram, int firstColumn, int columnCount);
+
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands whole frames from one writer thread to one reader thread without locks.
+// There are three copies of T. The writer fills its back copy and swaps it with the middle one,
+// the reader swaps its front copy for the middle one when something new has been put there. The
+// swaps are single atomic exchanges so neither side ever waits for the other, the reader always
+// gets the newest complete frame and frames it was too slow for are dropped
+template <typename T>
+class TripleBuffer {
+
+public:
+    // The copy the writer fills next
+    T &Back()
+    {
+        return buffers[back];
+    }
+
+    // Passes the back copy to the reader and takes the old middle copy as the new back
+    void Publish()
+    {
+        back = middle.exchange(uint8_t(back | FreshBit), std::memory_order_acq_rel) & IndexMask;
+    }
+
+    // Takes the newest published frame. Returns false when nothing was published since the last
+    // call, Front() is then still the frame from before
+    bool Update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FreshBit))
+        {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    const T &Front() const
+    {
+        return buffers[front];
+    }
+
+private:
+    static const uint8_t IndexMask = 3;
+    static const uint8_t FreshBit = 4; // set in middle while it holds a frame the reader hasn't taken
+
+    T buffers[3] = {};
+    uint8_t back = 0;               // writer only
+    std::atomic<uint8_t> middle{1}; // shared
+    uint8_t front = 2;              // reader only
+};
@@ -0,0 +1,140 @@
+#include "vram_convert.h"
+
+#if VRAM_CONVERT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+static const int ColumnBytes = VramConvertHeight / 8;
+
+void ConvertVramScalar(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette)
+{
+	for (int xPixel = column; xPixel < column + VramConvertBlock; ++xPixel)
+	{
+		// bit 0 of the column's first byte is its bottom pixel, each bit after it is one row up
+		uint32_t *pixel = &framebuffer[(VramConvertHeight - 1) * VramConvertWidth + xPixel];
+		const uint8_t *bytes = vram + xPixel * ColumnBytes;
+		for (int byteIndex = 0; byteIndex < ColumnBytes; ++byteIndex)
+		{
+			uint8_t videoByte = bytes[byteIndex];
+			for (int bitIndex = 0; bitIndex < 8; ++bitIndex)
+			{
+				*pixel = palette[videoByte & 0x1];
+				pixel -= VramConvertWidth;
+				videoByte = videoByte >> 1;
+			}
+		}
+	}
+}
+
+#if VRAM_CONVERT_X86
+
+// The byte at offset byteIndex of each of the 8 columns, column n in byte n
+static inline uint64_t GatherBlock(const uint8_t *vram, int column, int byteIndex)
+{
+	const uint8_t *bytes = vram + column * ColumnBytes + byteIndex;
+	uint64_t block = 0;
+	for (int index = 0; index < VramConvertBlock; ++index)
+	{
+		block |= uint64_t(bytes[index * ColumnBytes]) << (8 * index);
+	}
+	return block;
+}
+
+// movemask collects bit 7 of every byte, so with the 8 column bytes in one register it hands back
+// a screen row with column n in bit n. Adding the register to itself moves the next bit up.
+// Bit 7 is the highest of the 8 rows a byte covers, so the rows come out top to bottom
+void ConvertVramSse2(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette)
+{
+	const __m128i lowBits = _mm_setr_epi32(1, 2, 4, 8);
+	const __m128i highBits = _mm_setr_epi32(16, 32, 64, 128);
+	const __m128i off = _mm_set1_epi32(int(palette[0]));
+	const __m128i change = _mm_set1_epi32(int(palette[0] ^ palette[1]));
+	for (int byteIndex = 0; byteIndex < ColumnBytes; ++byteIndex)
+	{
+		uint64_t block = GatherBlock(vram, column, byteIndex);
+		__m128i bits = _mm_loadl_epi64((const __m128i *)&block);
+		uint32_t *row = &framebuffer[(VramConvertHeight - 8 - byteIndex * 8) * VramConvertWidth + column];
+		for (int bitIndex = 7; bitIndex >= 0; --bitIndex)
+		{
+			__m128i rowBits = _mm_set1_epi32(_mm_movemask_epi8(bits));
+			__m128i low = _mm_cmpeq_epi32(_mm_and_si128(rowBits, lowBits), lowBits);
+			__m128i high = _mm_cmpeq_epi32(_mm_and_si128(rowBits, highBits), highBits);
+			_mm_storeu_si128((__m128i *)row, _mm_xor_si128(off, _mm_and_si128(change, low)));
+			_mm_storeu_si128((__m128i *)(row + 4), _mm_xor_si128(off, _mm_and_si128(change, high)));
+			bits = _mm_add_epi8(bits, bits);
+			row += VramConvertWidth;
+		}
+	}
+}
+
+AVX2_TARGET void ConvertVramAvx2(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette)
+{
+	const __m256i pixelBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	const __m256i off = _mm256_set1_epi32(int(palette[0]));
+	const __m256i change = _mm256_set1_epi32(int(palette[0] ^ palette[1]));
+	for (int byteIndex = 0; byteIndex < ColumnBytes; ++byteIndex)
+	{
+		uint64_t block = GatherBlock(vram, column, byteIndex);
+		__m128i bits = _mm_loadl_epi64((const __m128i *)&block);
+		uint32_t *row = &framebuffer[(VramConvertHeight - 8 - byteIndex * 8) * VramConvertWidth + column];
+		for (int bitIndex = 7; bitIndex >= 0; --bitIndex)
+		{
+			__m256i rowBits = _mm256_set1_epi32(_mm_movemask_epi8(bits));
+			__m256i lit = _mm256_cmpeq_epi32(_mm256_and_si256(rowBits, pixelBits), pixelBits);
+			_mm256_storeu_si256((__m256i *)row, _mm256_xor_si256(off, _mm256_and_si256(change, lit)));
+			bits = _mm_add_epi8(bits, bits);
+			row += VramConvertWidth;
+		}
+	}
+}
+
+static bool CpuHasAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osSavesAvx = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesAvx && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+VramConverter SelectVramConverter()
+{
+#if VRAM_CONVERT_X86
+	static const VramConverter best = CpuHasAvx2() ? ConvertVramAvx2 : ConvertVramSse2;
+	return best;
+#else
+	return ConvertVramScalar;
+#endif
+}
+
+const char *VramConverterName(VramConverter converter)
+{
+#if VRAM_CONVERT_X86
+	if (converter == ConvertVramSse2)
+	{
+		return "sse2";
+	}
+	if (converter == ConvertVramAvx2)
+	{
+		return "avx2";
+	}
+#endif
+	return "scalar";
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VRAM_CONVERT_X86 1
+#else
+#define VRAM_CONVERT_X86 0
+#endif
+
+// Turns Space Invaders video RAM into the upright 224x256 ARGB8888 framebuffer the renderer
+// uploads. VRAM is column major at one bit per pixel: every screen column is 32 bytes with bit 0
+// of its first byte at the bottom. Going to rows is a bit transpose, done in 8x8 blocks. The
+// bytes at the same offset in 8 neighbouring columns hold an 8x8 square of the screen. Transposed,
+// that gives 8 row bytes, and each is expanded into 8 pixels through a two entry palette
+// {off, on}.
+// A converter fills the 8 columns starting at column, which must be a multiple of 8. vram points
+// at 0x2400 and framebuffer is 224 pixels wide
+typedef void (*VramConverter)(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette);
+
+static const int VramConvertWidth = 224;
+static const int VramConvertHeight = 256;
+static const int VramConvertBlock = 8; // columns per converter call
+
+// One bit at a time, the loop RenderPixels used to run. The reference for the others
+void ConvertVramScalar(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette);
+
+#if VRAM_CONVERT_X86
+// movemask transpose, 4 pixels per store
+void ConvertVramSse2(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette);
+
+// movemask transpose, 8 pixels per store
+void ConvertVramAvx2(const uint8_t *vram, int column, uint32_t *framebuffer, const uint32_t *palette);
+#endif
+
+// The fastest converter the cpu running this supports, checked once at runtime
+VramConverter SelectVramConverter();
+
+const char *VramConverterName(VramConverter converter);